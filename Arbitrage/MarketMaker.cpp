@@ -1,118 +1,298 @@
 #include "MarketMaker.h"
+#include "MarketDepths/FixedPoint.h"
 #include <iostream>
 #include <chrono>
 #include <cmath>
 #include <sstream>
 #include <limits>
+#include <algorithm>
 
-MarketMaker::MarketMaker(Config config) : _config(std::move(config)), _requests(_config.requests) {}
+MarketMaker::MarketMaker(Config config) : _config(std::move(config)), _requests(_config.requests) {
+    if (_requests && _config.presignWindowTicks > 0) _requests->enablePresign(_config.presignWindowTicks);
+}
 
 MarketMaker::~MarketMaker() { stop(); }
 
 void MarketMaker::start() {
     if (_running.exchange(true)) return;
+    if (_requests && _config.cancelAllWindowMs > 0) {
+        _requests->startCancelAllHeartbeat(_config.cancelAllWindowMs, std::max(_config.cancelAllWindowMs / 3, 1),
+                                           [this]() { return feedFresh(); },
+                                           [this]() {
+                                               // поток NetLoop: решение — в потоке стратегии
+                                               _protectionLost.store(true);
+                                               _events->interrupt();
+                                           });
+    }
     _worker = std::thread([this](){ runLoop(); });
 }
 
 void MarketMaker::stop() {
     if (!_running.exchange(false)) return;
-    _cv.notify_all();
+    _events->interrupt();
     if (_worker.joinable()) _worker.join();
+    if (_requests && _config.cancelAllWindowMs > 0) {
+        // стратегия остановлена — котировки без присмотра не оставляем. Синхронно: очередь лимита и конвейер
+        // гасятся вместе с LighterRequests и могли бы потерять cancel-all. Продления — только после ответа,
+        // а если ответа нет, ордера снимет последний запланированный cancel-all
+        if (!_requests->cancelAllOrders(_config.stopCancelTimeoutMs)) {
+            std::cerr << "[MarketMaker] cancel-all on stop not confirmed, orders expire in "
+                      << _config.cancelAllWindowMs << " ms" << std::endl;
+        }
+        _requests->stopCancelAllHeartbeat();
+    }
+}
+
+bool MarketMaker::feedFresh() const {
+    const long long last = _lastDepthAtNs.load(std::memory_order_relaxed);
+    if (last == 0) return false;
+    const long long ageNs = std::chrono::steady_clock::now().time_since_epoch().count() - last;
+    return ageNs < (long long) _config.cancelAllWindowMs * 1000000LL / 2;
 }
 
 void MarketMaker::updateMarketDepth(const MarketDepth &depth) {
-    {
-        std::lock_guard<std::mutex> lk(_mtx);
-        _lastDepth = depth;
-        _hasDepth = true;
+    _lastDepthAtNs.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    _depthFeed.publish(depth, -1);
+    // пачка стаканов до реакции стратегии — одно событие: читается всё равно последний снимок
+    if (_depthQueued.exchange(true)) return;
+    if (!_events->push([](StrategyEvent &ev) { ev.kind = StrategyEvent::Kind::Depth; })) _depthQueued.store(false);
+}
+
+bool MarketMaker::nextEvent(StrategyEvent &ev, std::chrono::steady_clock::time_point deadline) {
+    if (!_events->waitPop(ev, deadline)) return false;
+    // до чтения seqlock: стакан, пришедший после этого, снова поставит событие
+    if (ev.kind == StrategyEvent::Kind::Depth) _depthQueued.store(false);
+    return true;
+}
+
+TxAckTracker::Callback MarketMaker::ackToEvents() const {
+    std::weak_ptr<StrategyEventQueue> weak = _events;
+    return [weak](const TxAck &ack) {
+        auto events = weak.lock();
+        if (!events) return;
+        events->push([&ack](StrategyEvent &ev) {
+            ev.kind = StrategyEvent::Kind::TxAck;
+            ev.ack = ack;
+        });
+    };
+}
+
+void MarketMaker::handleTxAck(const TxAck &ack) {
+    if (ack.status == TxAck::Status::Accepted || ack.status == TxAck::Status::Superseded) return;
+    std::cerr << "[MarketMaker] tx " << ack.id << " failed (" << static_cast<int>(ack.status) << "): "
+              << ack.message << std::endl;
+    if (_pendingCreateId && *_pendingCreateId == ack.id) {
+        _createRejected = true; // ордер не встал — ждать его исполнения нечего
+        return;
     }
-    _cv.notify_one();
+    // modify не прошёл: забываем цель, следующий стакан отправит цену заново
+    _lastSubmittedPrice.reset();
 }
 
 void MarketMaker::runLoop() {
-    std::unique_lock<std::mutex> lk(_mtx);
+    // Каждый обработчик — ограниченное время, без ожиданий: ожидание только здесь, на очереди
     while (_running.load()) {
-        // мб убрать
-        _cv.wait(lk, [this] { return !_running.load() || _hasDepth; }); // ждём новый стакан
+        StrategyEvent ev;
+        if (nextEvent(ev, nextWakeup())) onEvent(ev);
         if (!_running.load()) break;
-        MarketDepth depth = _lastDepth;
-        _hasDepth = false;
-        lk.unlock();
+        onTimer(std::chrono::steady_clock::now());
+    }
+}
 
-        if (!hasGoodSpread(depth)) {
-            lk.lock();
-            continue;
-        }
-        // если позиции нет и не ждём заполнения, можно переписать на запросы, но эт медленно
-        if (!_hasPosition.load() && !_waitingForBid.load()) {
-            auto bidId = placeBidOrder(depth);
-            std::cout << "закончили placeBidOrder" << std::endl;
-            if (bidId) {
-                _waitingForBid.store(true);
-                std::cout << "начали waitForOrderExecution" << std::endl;
-                float filledBuy = waitForOrderExecution("BUY", _config.orderSize);
-                std::cout << filledBuy << "fieldbuy" << std::endl;
-                if (std::abs(filledBuy - 0.0f) <= 0.000000001) { // 0 != 0 c++
-                    _waitingForBid.store(false);
-                    lk.lock();
-                    continue;
-                }
-                _waitingForBid.store(false);
-                _hasPosition.store(true);
-                std::cout << "1" << std::endl;
-                auto askId = placeAskOrder(depth, filledBuy);
-                std::cout << "11" << std::endl;
-                if (askId) {
-                        _waitingForAsk.store(true);
-                        std::cout << filledBuy <<  "I\n";
-                        float filledSell = waitForOrderExecution("SELL", filledBuy);
-                        std::cout <<  filledSell << "II\n";
-                        if (filledSell == 0.0f) { // TODO: здесь надо наверно сравнивать с _config.orderSize
-                            _waitingForAsk.store(false);
-                            lk.lock();
-                            continue;
-                        }
-                        _waitingForAsk.store(false);
-                        _hasPosition.store(false);
-                    }
+std::chrono::steady_clock::time_point MarketMaker::nextWakeup() const {
+    const auto idle = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    return _state.load() == State::BidWorking ? std::min(idle, _bidDeadline) : idle;
+}
+
+const char *MarketMaker::stateName(State s) {
+    switch (s) {
+        case State::Idle: return "Idle";
+        case State::BidWorking: return "BidWorking";
+        case State::Long: return "Long";
+        case State::AskWorking: return "AskWorking";
+    }
+    return "?";
+}
+
+void MarketMaker::enter(State s) {
+    const State prev = _state.exchange(s);
+    if (prev != s) std::cout << "[MarketMaker] " << stateName(prev) << " -> " << stateName(s) << std::endl;
+}
+
+void MarketMaker::onEvent(const StrategyEvent &ev) {
+    switch (ev.kind) {
+        case StrategyEvent::Kind::Depth:
+            onDepth();
+            break;
+        case StrategyEvent::Kind::Order:
+        case StrategyEvent::Kind::Fill:
+            onOrderChanged();
+            break;
+        case StrategyEvent::Kind::TxAck:
+            handleTxAck(ev.ack);
+            if (!_createRejected) break;
+            _createRejected = false;
+            // ордер не встал: без позиции — снова ищем вход, с позицией — ask выставим на следующем стакане
+            if (_state.load() == State::BidWorking) enter(State::Idle);
+            else if (_state.load() == State::AskWorking) enter(State::Long);
+            break;
+    }
+}
+
+void MarketMaker::onDepth() {
+    if (_halted) return;
+    MarketDepth &depth = _loopDepth;
+    _depthFeed.read(depth);
+    presign(depth);
+    switch (_state.load()) {
+        case State::Idle:
+            if (!hasGoodSpread(depth)) return;
+            if (placeBidOrder(depth)) {
+                _bidDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_config.bidTimeoutMs);
+                enter(State::BidWorking);
+            }
+            return;
+        case State::BidWorking:
+            if (_bidCancelPending) return; // остаток снимается — не переставляем
+            reprice(depth, AccountAllOrdersWS::Side::Buy, _config.orderSize);
+            return;
+        case State::Long:
+            tryPlaceAsk();
+            return;
+        case State::AskWorking:
+            reprice(depth, AccountAllOrdersWS::Side::Sell, _positionBase);
+            return;
+    }
+}
+
+void MarketMaker::onOrderChanged() {
+    const std::optional<AccountAllOrdersWS::Order> cur = currentOrder();
+    if (!cur || !cur->isTerminal()) return;
+    if (_state.load() == State::BidWorking) {
+        // исполнен, снят нами или биржей (post-only и т.п.): объём окончательный — продаём исполненное
+        settleBid(cur);
+    } else if (_state.load() == State::AskWorking) {
+        if (!cur->isFilled()) {
+            // ask снят: проданное до отмены из позиции вычитаем, остаток выставим заново
+            _positionBase -= filledBase(*cur);
+            if (_loopDepth.toLots(_positionBase) <= 0) {
+                _positionBase = 0;
+                enter(State::Idle);
+                return;
             }
+            enter(State::Long);
+            return;
+        }
+        _positionBase = 0;
+        enter(State::Idle);
+    }
+}
+
+void MarketMaker::onTimer(std::chrono::steady_clock::time_point now) {
+    if (_protectionLost.exchange(false)) halt();
+    if (_orderEventLost.exchange(false)) onOrderChanged();
+    if (_halted) return;
+    if (_state.load() != State::BidWorking || now < _bidDeadline) return;
+    if (_bidCancelPending) {
+        // подтверждение отмены так и не пришло — продаём то, что известно к этому моменту
+        std::cerr << "[MarketMaker] bid cancel not confirmed in " << _config.bidCancelTimeoutMs
+                  << " ms, selling the last known fill" << std::endl;
+        settleBid(currentOrder());
+        return;
+    }
+    finishBid(currentOrder());
+}
+
+void MarketMaker::finishBid(const std::optional<AccountAllOrdersWS::Order> &cur) {
+    // bid больше не ждём: живой остаток снимаем и ждём его конечного статуса — до него bid ещё может
+    // исполняться, и эти исполнения должны попасть в позицию
+    if (!_bidCancelPending && cur && !cur->isTerminal() && cur->order_index != 0 && _requests) {
+        try {
+            _requests->submitCancelOrder(cur->order_index, ackToEvents());
+            _bidCancelPending = true;
+            _bidDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_config.bidCancelTimeoutMs);
+            return;
+        } catch (const std::exception &ex) {
+            std::cerr << "cancelOrder BID error: " << ex.what() << "\n";
         }
-        std::cout << "----------------" << std::endl;
-        lk.lock();
+    }
+    settleBid(cur);
+}
+
+void MarketMaker::settleBid(const std::optional<AccountAllOrdersWS::Order> &cur) {
+    _bidCancelPending = false;
+    const float filled = cur ? filledBase(*cur) : 0.0f;
+    if (filled <= 0.0f) {
+        enter(State::Idle);
+        return;
+    }
+    _positionBase = filled;
+    enter(State::Long);
+    _depthFeed.read(_loopDepth); // ask — от самого свежего стакана
+    tryPlaceAsk();
+}
+
+void MarketMaker::tryPlaceAsk() {
+    if (_halted) return;
+    if (placeAskOrder(_loopDepth, _positionBase)) enter(State::AskWorking);
+}
+
+void MarketMaker::halt() {
+    if (_halted) return;
+    _halted = true;
+    // dead-man switch больше не продлевается — без него котировки не оставляем
+    std::cerr << "[MarketMaker] cancel-all heartbeat gave up, quoting stopped in " << stateName(_state.load())
+              << ", position " << _positionBase << std::endl;
+    if (!_requests) return;
+    try {
+        _requests->submitCancelAllOrders(ackToEvents());
+    } catch (const std::exception &ex) {
+        std::cerr << "[MarketMaker] cancel-all after heartbeat loss failed: " << ex.what() << std::endl;
     }
 }
 
+std::optional<AccountAllOrdersWS::Order> MarketMaker::currentOrder() const {
+    std::lock_guard<std::mutex> lk(_ordersMtx);
+    return _currentOrder;
+}
+
 bool MarketMaker::hasGoodSpread(const MarketDepth &depth) const {
     if (depth.bids.empty() || depth.asks.empty()) return false;
-    const float bid = depth.bids.front().first;
-    const float ask = depth.asks.front().first;
-    if (bid <= 0.0f || ask <= 0.0f || ask <= bid) return false;
-    const float mid = (bid + ask) * 0.5f;
-    const float spreadPct = ((ask - bid) / mid) * 100.0f;
+    const long long bid = depth.bidTicks(0);
+    const long long ask = depth.askTicks(0);
+    if (bid <= 0 || ask <= 0 || ask <= bid) return false;
+    const double mid = (double)(bid + ask) * 0.5;
+    const double spreadPct = ((double)(ask - bid) / mid) * 100.0;
     return spreadPct >= _config.minSpreadPct;
 }
 
+long long MarketMaker::tickTicks(const MarketDepth &depth) const {
+    const long long t = depth.toTicks(_config.tickSize);
+    return t > 0 ? t : 1;
+}
+
+void MarketMaker::presign(const MarketDepth &depth) {
+    if (!_requests || _config.presignWindowTicks <= 0) return;
+    _requests->presignBook(depth.bidTicks(0), depth.askTicks(0), tickTicks(depth), depth.toLots(_config.orderSize));
+}
+
 std::optional<std::string> MarketMaker::placeBidOrder(const MarketDepth &depth) {
-    const float bestBid = depth.bids.empty() ? 0.0f : depth.bids.front().first;
-    const float bidPrice = bestBid + _config.tickSize;
+    // всё в тиках/лотах — цена уходит в signer без float-округлений
+    const long long px = depth.bidTicks(0) + tickTicks(depth);
     try {
         if (_requests) {
-            std::ostringstream qty;
-            qty << (_config.orderSize);
-            double px = static_cast<double>(bidPrice);
-            std::string resp = _requests->createOrder(
-                    _config.symbol,
-                    "BUY",
-                    "LIMIT", // todo это не учитывается
-                    qty.str(),
-                    px
-            );
+            _requests->presignModifyTarget(0, false, 0); // прошлый ордер закрыт
             {
-                //
+                // до отправки: обновление нового ордера может прийти раньше, чем вернётся submit
                 std::lock_guard<std::mutex> lk(_ordersMtx);
                 _currentOrder.reset();
-                _lastSubmittedPrice = px; // фиксируем последнюю отправленную цену
+                _workingSide = AccountAllOrdersWS::Side::Buy;
             }
+            std::string resp = _requests->submitCreateOrder("BUY", depth.toLots(_config.orderSize), px, ackToEvents());
+            _pendingCreateId = resp;
+            _createRejected = false;
+            _bidCancelPending = false;
+            _lastSubmittedPrice = px; // фиксируем последнюю отправленную цену
             return std::make_optional<std::string>(resp);
         }
     } catch (const std::exception &ex) {
@@ -122,27 +302,21 @@ std::optional<std::string> MarketMaker::placeBidOrder(const MarketDepth &depth)
 }
 
 std::optional<std::string> MarketMaker::placeAskOrder(const MarketDepth &depth, float quantity) {
-    const float bestAsk = depth.asks.empty() ? 0.0f : depth.asks.front().first;
-    const float askPrice = bestAsk - _config.tickSize;
+    const long long px = depth.askTicks(0) - tickTicks(depth);
     std::cout << quantity << "sell qu" << std::endl;
     try {
         if (_requests) {
-            std::ostringstream qty;
-            qty << quantity;
-            double px = static_cast<double>(askPrice);
-            std::cout << px << " SELLLLLLLLLLLLLLLLL"<< std::endl;
-            std::string resp = _requests->createOrder(
-                    _config.symbol,
-                    "SELL",
-                    "LIMIT", // todo это не учитывается
-                    qty.str(),
-                    px
-            );
+            std::cout << depth.toPrice(px) << " SELLLLLLLLLLLLLLLLL"<< std::endl;
+            _requests->presignModifyTarget(0, false, 0); // прошлый ордер закрыт
             {
                 std::lock_guard<std::mutex> lk(_ordersMtx);
                 _currentOrder.reset();
-                _lastSubmittedPrice = px; // фиксируем последнюю отправленную цену
+                _workingSide = AccountAllOrdersWS::Side::Sell;
             }
+            std::string resp = _requests->submitCreateOrder("SELL", depth.toLots(quantity), px, ackToEvents());
+            _pendingCreateId = resp;
+            _createRejected = false;
+            _lastSubmittedPrice = px; // фиксируем последнюю отправленную цену
             return std::make_optional<std::string>(resp);
         }
     } catch (const std::exception &ex) {
@@ -151,140 +325,80 @@ std::optional<std::string> MarketMaker::placeAskOrder(const MarketDepth &depth,
     return std::nullopt;
 }
 
-float MarketMaker::waitForOrderExecution(std::string side, float orderBaseQuantity) {
-    float filledVolume = 0;
-    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(90);
-    bool continueTrading = true;
-    while (continueTrading) { // можно улучшить чтобы продажа безх запроса времени была
-
-        // Проверка статуса без блокировки на длительное время
-        // todo попробовать избавиться
-        std::optional<OrderLite> cur;
-        {
-            std::lock_guard<std::mutex> lk(_ordersMtx);
-            cur = _currentOrder;
-        }
+float MarketMaker::filledBase(const AccountAllOrdersWS::Order &order) const {
+    // скейл объёма — тот же, что у стакана. Именно filled, а не size - remaining:
+    // у снятого ордера остаток может прийти нулём
+    return (float) fixedpoint::toDouble(order.filled_base_amount, _loopDepth.sizeScale);
+}
 
-        if (cur && cur->status == "filled") {
-            filledVolume = _config.orderSize - std::stof(cur->remaining_base_amount);
-            std::cout << filledVolume << " 3" << std::endl;
-            return filledVolume;
-        }
+void MarketMaker::reprice(const MarketDepth &depth, AccountAllOrdersWS::Side side, float orderBaseQuantity) {
+    const bool isBuy = side == AccountAllOrdersWS::Side::Buy;
+    const std::optional<AccountAllOrdersWS::Order> cur = currentOrder();
+    // Цены в тиках — сравнения точные
+    long long best = 0;
+    long long second = 0;
+    if (isBuy) {
+        best = depth.bidTicks(0);
+        second = depth.bidTicks(1);
+    } else {
+        best = depth.askTicks(0);
+        second = depth.askTicks(1);
+    }
+    const long long tick = tickTicks(depth);
 
-        // Дождаться СЛЕДУЮЩЕГО обновления стакана и только затем пересчитать цену
-        MarketDepth depthSnapshot;
-        {
-            std::unique_lock<std::mutex> lk(_mtx);
-            _hasDepth = false; // ждём именно новое обновление
-            auto deadlineDepth = std::chrono::steady_clock::now() + std::chrono::milliseconds(1500);
-            _cv.wait_until(lk, deadlineDepth, [this]{ return !_running.load() || _hasDepth; });
-            if (!_running.load()) {
-                if (cur) {
-                    filledVolume = _config.orderSize - std::stof(cur->remaining_base_amount);
-                } else {
-                    filledVolume = 0.0f;
-                }
-                std::cout << filledVolume << " 33" << std::endl;
-                return filledVolume;
-            }
-            depthSnapshot = _lastDepth;
-            _hasDepth = false;
-        }
-        float best = 0.0f;
-        float second = 0.0f;
-        if (side == "BUY") {
-            best = depthSnapshot.bids.empty() ? 0.0f : depthSnapshot.bids.front().first;
-            second = (depthSnapshot.bids.size() >= 2) ? depthSnapshot.bids[1].first : 0.0f;
-        } else {
-            best = depthSnapshot.asks.empty() ? 0.0f : depthSnapshot.asks.front().first;
-            second = (depthSnapshot.asks.size() >= 2) ? depthSnapshot.asks[1].first : 0.0f;
-        }
+    // База для нового цены: если топ-1 — наш, используем топ-2; иначе — топ-1
+    long long base = best;
+    if (_lastSubmittedPrice.has_value() && std::llabs(_lastSubmittedPrice.value() - best) <= tick) {
+        if (second > 0) base = second; // топ-1 наш — используем топ-2
+    }
+    long long newPrice = isBuy ? (base + tick) : (base - tick);
 
-        // База для нового цены: если топ-1 — наш, используем топ-2; иначе — топ-1
-        float base = best;
-        const double eps = std::max(1e-9, (double)_config.tickSize);
+    this->cutPriceIfBadSpread(hasGoodSpread(depth), side, newPrice);
 
-        if (_lastSubmittedPrice.has_value() && std::fabs(_lastSubmittedPrice.value() - best) <= _config.tickSize) {
-            if (second > 0.0f) base = second; // топ-1 наш — используем топ-2
-        }
-        double newPrice = (side == "BUY") ? ((double)base + _config.tickSize)
-                                            : ((double)base - _config.tickSize);
-
-        this->cutPriceIfBadSpread(hasGoodSpread(depthSnapshot), side, newPrice);
-
-        // Если новая цена совпадает с уже отправленной — ничего не делаем
-        if (_lastSubmittedPrice.has_value() && std::fabs(_lastSubmittedPrice.value() - newPrice) <= eps) {
-            //std::cout << "CONTINUE -----------------------------------" << std::endl;
-            if (side == "SELL") {
-                continueTrading = true;
-            } else {
-                continueTrading = std::chrono::steady_clock::now() < deadline;
-                if (cur) {
-                    filledVolume = _config.orderSize - std::stof(cur->remaining_base_amount);
-                }
-            }
-            continue; // ждём обновления книги/ордера
-        }
+    // Если новая цена совпадает с уже отправленной — ничего не делаем
+    if (_lastSubmittedPrice.has_value() && _lastSubmittedPrice.value() == newPrice) return;
 
-        std::ostringstream qty;
-        qty << orderBaseQuantity;
-
-        if (cur && _requests) {
-            // 1) Если статус уже filled/cancelled — прекращаем
-            long long orderIndex = 0;
-            try { orderIndex = std::stoll(cur->order_id); } catch (...) { /* skip */ }
-            if (orderIndex != 0) {
-                try {
-                    //std::cout << newPrice << std::endl;
-                    //std::this_thread::sleep_for(std::chrono::milliseconds(5)); // задержка 50мс перед модификацией
-                    (void)_requests->modifyOrder(_config.symbol, qty.str(), newPrice, orderIndex, side, hasGoodSpread(depthSnapshot));
-                    //std::this_thread::sleep_for(std::chrono::milliseconds(50));
-                    _lastSubmittedPrice = newPrice; // обновляем локально целью
-                } catch (const std::exception &ex) {
-                    std::cerr << "modifyOrder error: " << ex.what() << "\n";
-                }
-            }
-        }
-        if (side == "SELL") {
-            continueTrading = true;
-        } else {
-            continueTrading = std::chrono::steady_clock::now() < deadline;
-            if (!continueTrading) {
-                if (cur) {
-                    filledVolume = _config.orderSize - std::stof(cur->remaining_base_amount);
-                } else {
-                    filledVolume = 0.0f;
-                }
-                return filledVolume;
-            }
-        }
+    // Лимит почти выбран — не гонимся за ценой, токены нужнее для cancel
+    const bool budgetOk = !_requests || _requests->txBudget().tokens >= _config.txBudgetReserve;
+    if (!cur || !_requests || !budgetOk) return;
+    const long long orderIndex = cur->order_index;
+    if (orderIndex == 0) return; // биржа ещё не присвоила индекс — modify подождёт следующего стакана
+    try {
+        const long long lots = depth.toLots(orderBaseQuantity);
+        (void)_requests->submitModifyOrder(orderIndex, lots, newPrice, ackToEvents());
+        // следующий modify этого ордера — скорее всего рядом с новой ценой
+        _requests->presignModifyTarget(orderIndex, !isBuy, lots);
+        _lastSubmittedPrice = newPrice; // обновляем локально целью
+    } catch (const std::exception &ex) {
+        std::cerr << "modifyOrder error: " << ex.what() << "\n";
     }
-    std::cout << filledVolume << " 333" << std::endl;
-
-    return filledVolume;
 }
 
-void MarketMaker::cutPriceIfBadSpread(bool hasGoodSpread, const std::string &side, double &acceptablePriceInt) {
-    if (!hasGoodSpread && side == "BUY") // если плохой спред
+void MarketMaker::cutPriceIfBadSpread(bool hasGoodSpread, AccountAllOrdersWS::Side side, long long &acceptablePriceInt) {
+    if (!hasGoodSpread && side == AccountAllOrdersWS::Side::Buy) // если плохой спред
     {
-        acceptablePriceInt *= 0.9;
+        acceptablePriceInt = acceptablePriceInt * 9 / 10;
     }
 }
 
 void MarketMaker::updateOrder(const AccountAllOrdersWS::Order &o) {
-    OrderLite L;
-    L.order_index = o.order_index;
-    L.order_id = o.order_id;
-    L.client_order_id = o.client_order_id;
-    L.side = o.side;
-    L.type = o.type;
-    L.status = o.status;
-    L.price = o.price;
-    L.remaining_base_amount = o.remaining_base_amount;
-    L.timestamp = o.timestamp;
+    bool fill;
     {
         std::lock_guard<std::mutex> lk(_ordersMtx);
-        _currentOrder = std::move(L);
+        // обновления прошлых ордеров (снятый остаток bid, пока работает ask) — не наши
+        if (o.side != _workingSide && !(_currentOrder && _currentOrder->order_index == o.order_index)) return;
+        const long long before = (_currentOrder && _currentOrder->order_index == o.order_index)
+                                 ? _currentOrder->filled_base_amount : 0;
+        fill = o.isFilled() || o.filled_base_amount > before;
+        _currentOrder = o;
+    }
+    const bool queued = _events->push([&o, fill](StrategyEvent &ev) {
+        ev.kind = fill ? StrategyEvent::Kind::Fill : StrategyEvent::Kind::Order;
+        ev.order = o;
+    });
+    // очередь полна: само обновление уже в _currentOrder, стратегия перечитает его на ближайшем проходе цикла
+    if (!queued) {
+        _orderEventLost.store(true);
+        _events->interrupt();
     }
-    _ordersCv.notify_all();
 }
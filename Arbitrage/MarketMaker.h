@@ -4,23 +4,47 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <condition_variable>
+#include <chrono>
 #include <memory>
 #include <optional>
 
 #include "AccountAllOrdersWS.h"
 #include "MarketDepths/MarketDepth.h"
+#include "MarketDepths/DepthSeqLock.h"
+#include "StrategyEvents.h"
 #include "requests/lighter/LighterRequests.h"
 #include "MarketDepths/AccountAllOrdersWS.h"
 
+// Стратегия — явный автомат: Idle -> BidWorking -> Long -> AskWorking -> Idle.
+// Каждое событие (стакан, обновление ордера, ответ на tx, таймер) продвигает состояние за
+// ограниченное время, без ожиданий внутри; ждёт только цикл на очереди событий
 class MarketMaker {
 public:
+    enum class State : uint8_t {
+        Idle,       // позиции нет, ждём спред
+        BidWorking, // bid выставлен, переставляем за книгой до исполнения или bidTimeoutMs
+        Long,       // позиция есть, ask ещё не стоит (не встал или не выставлен)
+        AskWorking, // ask выставлен, переставляем до исполнения
+    };
+
     struct Config {
         std::string symbol;     // market_index
         float minSpreadPct;     // минимальный спред в % для начала торговли
         float orderSize;        // размер ордера (в базовой валюте)
         float tickSize;         // размер тика (абсолютный шаг цены)
         std::shared_ptr<LighterRequests> requests; // клиент для отправки ордеров
+        int presignWindowTicks = 0; // >0 — предподписывать ордера на столько тиков вокруг лучших цен
+        // >0 — dead-man switch: без продлений (падение или стакан старше половины окна) биржа
+        // снимет все ордера через столько мс; продление — каждую треть окна
+        int cancelAllWindowMs = 0;
+        // Сколько stop() ждёт ответа биржи на финальный cancel-all
+        int stopCancelTimeoutMs = 3000;
+        // Перестановку цены пропускаем, если токенов лимита меньше этого: запас для cancel
+        double txBudgetReserve = 2.0;
+        // Столько bid ждёт полного исполнения; затем остаток снимается, исполненное продаётся
+        int bidTimeoutMs = 90000;
+        // Столько ждём конечного статуса снимаемого bid; не пришёл — продаём последнее известное исполнение
+        int bidCancelTimeoutMs = 5000;
     };
 
     explicit MarketMaker(Config config);
@@ -29,18 +53,55 @@ public:
     void start();
     void stop();
 
-    // Принимаем свежий снимок стакана
+    // Принимаем свежий снимок стакана (из потока фида): публикация без блокировок и аллокаций
     void updateMarketDepth(const MarketDepth &depth);
+    // Задержка от события (стакан, ордер, исполнение, ответ на tx) до реакции стратегии
+    StrategyEventQueue::Stats eventStats() const { return _events->stats(); }
+    State state() const { return _state.load(); }
+    static const char *stateName(State s);
 
 private:
     void runLoop();
+    // Обработчики автомата (поток стратегии): каждый — ограниченное время, без ожиданий
+    void onEvent(const StrategyEvent &ev);
+    void onDepth();
+    void onOrderChanged();
+    void onTimer(std::chrono::steady_clock::time_point now);
+    void enter(State s);
+    // Выход из BidWorking без полного исполнения: снять остаток и остаться в BidWorking до его
+    // конечного статуса; bid уже снят — сразу settleBid
+    void finishBid(const std::optional<AccountAllOrdersWS::Order> &cur);
+    // Итог bid: исполненное — в Long и ask на него, ничего — в Idle
+    void settleBid(const std::optional<AccountAllOrdersWS::Order> &cur);
+    // Когда проснуться без событий: дедлайн bid или раз в секунду — проверить остановку
+    std::chrono::steady_clock::time_point nextWakeup() const;
+    // Выставить ask на _positionBase по _loopDepth; не встал — остаёмся в Long до следующего стакана
+    void tryPlaceAsk();
+    // Dead-man switch сдался: новых ордеров и перестановок больше нет, всё стоящее — снять
+    void halt();
+    // Переставить активный ордер за лучшей ценой (modify), если цена изменилась
+    void reprice(const MarketDepth &depth, AccountAllOrdersWS::Side side, float orderBaseQuantity);
+    std::optional<AccountAllOrdersWS::Order> currentOrder() const;
     bool hasGoodSpread(const MarketDepth &depth) const;
+    // tickSize в тиках стакана (минимум 1)
+    long long tickTicks(const MarketDepth &depth) const;
+    // Сдвинуть центр предподписанной лестницы за книгой
+    void presign(const MarketDepth &depth);
+    // Стакан приходил недавно — можно продлевать dead-man switch
+    bool feedFresh() const;
+    // Следующее событие стратегии или таймаут; стакан после этого читается из seqlock
+    bool nextEvent(StrategyEvent &ev, std::chrono::steady_clock::time_point deadline);
+    // onAck для наших транзакций: ответ уходит в очередь событий, а не в поток NetLoop
+    TxAckTracker::Callback ackToEvents() const;
+    // Ответ на нашу транзакцию (поток стратегии)
+    void handleTxAck(const TxAck &ack);
 
-    // Выставление заявок (пока заглушка с логированием и фиктивным id)
+    // Выставление заявок: возвращают id запроса sendtx сразу, подпись и отправка — в конвейере LighterRequests
     std::optional<std::string> placeBidOrder(const MarketDepth &depth);
     std::optional<std::string> placeAskOrder(const MarketDepth &depth, float quantity);
-    float waitForOrderExecution(std::string side, float orderBaseQuantity);
-    void cutPriceIfBadSpread(bool hasGoodSpread, const std::string &side, double &acceptablePriceInt);
+    void cutPriceIfBadSpread(bool hasGoodSpread, AccountAllOrdersWS::Side side, long long &acceptablePriceInt);
+    // Исполненный объём активного ордера в базовой валюте (приходит в лотах)
+    float filledBase(const AccountAllOrdersWS::Order &order) const;
     
 public:
     // Обновление одной сделки
@@ -51,35 +112,36 @@ private:
     std::thread _worker;
     std::atomic<bool> _running{false};
 
-    mutable std::mutex _mtx;
-    std::condition_variable _cv;
-    MarketDepth _lastDepth;
-    bool _hasDepth{false};
+    // Все пробуждения стратегии — через одну очередь; сам стакан идёт через seqlock.
+    // shared_ptr: onAck транзакций может прийти и после остановки стратегии
+    std::shared_ptr<StrategyEventQueue> _events{std::make_shared<StrategyEventQueue>()};
+    std::atomic<bool> _depthQueued{false}; // событие о стакане уже в очереди — следующие не множим
+    DepthSeqLock _depthFeed;
+    std::atomic<long long> _lastDepthAtNs{0}; // steady_clock последнего стакана
+    std::atomic<bool> _protectionLost{false};  // heartbeat сдался, ещё не обработано стратегией
+    std::atomic<bool> _orderEventLost{false};  // событие ордера не влезло в очередь — перечитать _currentOrder
+    bool _halted{false};                       // котирование остановлено (только поток стратегии)
+    // рабочая копия стакана потока стратегии, ёмкость переиспользуется
+    MarketDepth _loopDepth;
 
-    // Состояние сделки
-    std::atomic<bool> _hasPosition{false};
-    std::atomic<bool> _waitingForBid{false};
-    std::atomic<bool> _waitingForAsk{false};
+    // Состояние сделки: пишет только поток стратегии, читать можно откуда угодно
+    std::atomic<State> _state{State::Idle};
+    std::chrono::steady_clock::time_point _bidDeadline; // в ожидании отмены — срок её подтверждения
+    bool _bidCancelPending{false}; // остаток bid снимается, ждём конечного статуса
+    float _positionBase{0}; // позиция в базовой валюте (Long / AskWorking)
     std::shared_ptr<LighterRequests> _requests;
 
-    // Отслеживание статуса ордеров
-    struct OrderLite {
-        long long order_index{0};
-        std::string order_id;
-        std::string client_order_id;
-        std::string side;
-        std::string type;
-        std::string status;
-        std::string price;
-        std::string remaining_base_amount;
-        long long timestamp{0};
-    };
+    // Отслеживание статуса ордеров: запись — одна кэш-линия, копия под локом без аллокаций
     mutable std::mutex _ordersMtx;
-    std::condition_variable _ordersCv;
-    std::optional<OrderLite> _currentOrder; // одна активная сделка
+    std::optional<AccountAllOrdersWS::Order> _currentOrder; // одна активная сделка
+    // сторона активного ордера: обновления прошлых ордеров другой стороны не подменяют текущий
+    AccountAllOrdersWS::Side _workingSide{AccountAllOrdersWS::Side::Buy};
+    // id sendtx выставленного ордера и отказ по нему (только поток стратегии)
+    std::optional<std::string> _pendingCreateId;
+    bool _createRejected{false};
 
-    // Последняя отправленная нами цена активного ордера
-    std::optional<double> _lastSubmittedPrice;
+    // Последняя отправленная нами цена активного ордера (в тиках)
+    std::optional<long long> _lastSubmittedPrice;
 };
 
 
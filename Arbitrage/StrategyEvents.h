@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "MarketDepths/MpscRing.h"
+#include "MarketDepths/AccountAllOrdersWS.h"
+#include "requests/lighter/TxAckTracker.h"
+
+// Событие для потока стратегии. Стакан само событие не несёт — свежий снимок лежит в seqlock,
+// событие лишь будит; ордер (одна кэш-линия) и ответ на транзакцию едут в самом событии
+struct StrategyEvent {
+    enum class Kind : uint8_t { Depth, Order, Fill, TxAck };
+
+    Kind kind{Kind::Depth};
+    long long atNs{0};                 // steady_clock постановки в очередь
+    AccountAllOrdersWS::Order order;   // Order / Fill
+    TxAck ack;                         // TxAck
+};
+
+// Единая очередь событий стратегии: стакан, ордера, исполнения и ответы на транзакции —
+// в порядке прихода, из любых потоков. Поток стратегии спит, пока очередь пуста, и просыпается
+// на первом же событии: писатель трогает мьютекс, только если читатель действительно спит.
+class StrategyEventQueue {
+public:
+    struct Stats {
+        uint64_t pushed{0};
+        uint64_t dropped{0};          // очередь была полна (отправитель сам решает, как не потерять состояние)
+        uint64_t wakeups{0};          // читатель спал и был разбужен событием
+        long long lastLatencyUs{0};   // от постановки до извлечения
+        long long maxLatencyUs{0};
+    };
+
+    explicit StrategyEventQueue(size_t capacity = 1024) : _ring(capacity) {}
+
+    // Любой поток. fill(StrategyEvent&) заполняет слот на месте; false — очередь полна
+    template <typename F>
+    bool push(F &&fill) {
+        const long long now = std::chrono::steady_clock::now().time_since_epoch().count();
+        const bool ok = _ring.tryPush([&](StrategyEvent &ev) {
+            fill(ev);
+            ev.atNs = now;
+        });
+        if (ok) _pushed.fetch_add(1, std::memory_order_relaxed);
+        else _dropped.fetch_add(1, std::memory_order_relaxed);
+        // пара к забору в waitPop: либо читатель увидит событие, либо мы — что он спит
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lk(_mtx);
+            _cv.notify_one();
+        }
+        return ok;
+    }
+
+    // Только поток стратегии: следующее событие или ожидание до deadline.
+    // false — таймаут или interrupt()
+    bool waitPop(StrategyEvent &out, std::chrono::steady_clock::time_point deadline) {
+        if (popNow(out)) return true;
+        std::unique_lock<std::mutex> lk(_mtx);
+        while (true) {
+            _sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (popNow(out)) break;
+            if (_interrupted.exchange(false)) {
+                _sleeping.store(false, std::memory_order_relaxed);
+                return false;
+            }
+            if (_cv.wait_until(lk, deadline) == std::cv_status::timeout) {
+                _sleeping.store(false, std::memory_order_relaxed);
+                return popNow(out);
+            }
+            _wakeups.fetch_add(1, std::memory_order_relaxed);
+        }
+        _sleeping.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Разбудить читателя без события (остановка, флаг вместо не влезшего события)
+    void interrupt() {
+        std::lock_guard<std::mutex> lk(_mtx);
+        _interrupted.store(true);
+        _cv.notify_one();
+    }
+
+    Stats stats() const {
+        Stats s;
+        s.pushed = _pushed.load();
+        s.dropped = _dropped.load();
+        s.wakeups = _wakeups.load();
+        s.lastLatencyUs = _lastLatencyUs.load();
+        s.maxLatencyUs = _maxLatencyUs.load();
+        return s;
+    }
+
+private:
+    bool popNow(StrategyEvent &out) {
+        const bool ok = _ring.tryPop([&](StrategyEvent &ev) {
+            out.kind = ev.kind;
+            out.atNs = ev.atNs;
+            out.order = ev.order;
+            if (ev.kind == StrategyEvent::Kind::TxAck) std::swap(out.ack, ev.ack); // ёмкость строк остаётся в слотах
+        });
+        if (!ok) return false;
+        const long long us = (std::chrono::steady_clock::now().time_since_epoch().count() - out.atNs) / 1000;
+        _lastLatencyUs.store(us, std::memory_order_relaxed);
+        if (us > _maxLatencyUs.load(std::memory_order_relaxed)) _maxLatencyUs.store(us, std::memory_order_relaxed);
+        return true;
+    }
+
+    MpscRing<StrategyEvent> _ring;
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::atomic<bool> _sleeping{false};
+    std::atomic<bool> _interrupted{false};
+
+    std::atomic<uint64_t> _pushed{0};
+    std::atomic<uint64_t> _dropped{0};
+    std::atomic<uint64_t> _wakeups{0};
+    std::atomic<long long> _lastLatencyUs{0};
+    std::atomic<long long> _maxLatencyUs{0};
+};
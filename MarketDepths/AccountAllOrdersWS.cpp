@@ -1,4 +1,5 @@
 #include "AccountAllOrdersWS.h"
+#include "AccountOrdersFrame.h"
 #include <iostream>
 #include <sstream>
 
@@ -11,157 +12,152 @@ std::string AccountAllOrdersWS::buildSubscribe(const std::string &accountId, con
     return os.str();
 }
 
-AccountAllOrdersWS::AccountAllOrdersWS(Config cfg) : _cfg(std::move(cfg)) {}
+AccountAllOrdersWS::AccountAllOrdersWS(Config cfg) : _cfg(std::move(cfg)), _frame(std::make_unique<AccountOrdersFrame>()) {
+    WsSupervisor::Config scfg;
+    scfg.name = "AccountAllOrdersWS " + _cfg.accountId;
+    scfg.client.url = _cfg.url;
+    scfg.client.extraHeaders = _cfg.extraHeaders;
+    if (!_cfg.authToken.empty()) scfg.client.extraHeaders.emplace_back(std::string("Authorization: Bearer ") + _cfg.authToken);
+    scfg.client.initialText = buildSubscribe(_cfg.accountId, _cfg.authToken);
+    scfg.client.onMessage = [this](std::string_view data){ handleMessage(data); };
+    _supervisor = std::make_unique<WsSupervisor>(std::move(scfg));
+}
 AccountAllOrdersWS::~AccountAllOrdersWS() { stop(); }
 
 void AccountAllOrdersWS::start() {
     if (_running.exchange(true)) return;
-    _thr = std::thread([this](){ run(); });
+    std::cout << "[AccountAllOrdersWS] starting: " << _cfg.url << " account=" << _cfg.accountId << std::endl;
+    _supervisor->start();
 }
 
 void AccountAllOrdersWS::stop() {
     if (!_running.exchange(false)) return;
-    if (_thr.joinable()) _thr.join();
+    _supervisor->stop();
+    std::cout << "[AccountAllOrdersWS] stopped" << std::endl;
 }
 
 std::unordered_map<int, std::vector<AccountAllOrdersWS::Order>> AccountAllOrdersWS::getOrders() const {
+    std::unordered_map<int, std::vector<Order>> byMarket;
     std::lock_guard<std::mutex> lk(_mtx);
-    return _ordersByMarket;
+    for (const auto &o : _open) byMarket[o.market_index].push_back(o);
+    return byMarket;
+}
+
+std::optional<AccountAllOrdersWS::Order> AccountAllOrdersWS::findOrder(long long orderIndex) const {
+    std::lock_guard<std::mutex> lk(_mtx);
+    auto it = _byOrderIndex.find(orderIndex);
+    if (it == _byOrderIndex.end()) return std::nullopt;
+    return _open[it->second];
+}
+
+std::optional<AccountAllOrdersWS::OrderDetails> AccountAllOrdersWS::findOrderDetails(long long orderIndex) const {
+    std::lock_guard<std::mutex> lk(_mtx);
+    auto it = _byOrderIndex.find(orderIndex);
+    if (it == _byOrderIndex.end()) return std::nullopt;
+    return _details[it->second];
+}
+
+size_t AccountAllOrdersWS::openOrderCount() const {
+    std::lock_guard<std::mutex> lk(_mtx);
+    return _open.size();
+}
+
+void AccountAllOrdersWS::resetLocked() {
+    _open.clear();
+    _details.clear();
+    _byOrderIndex.clear();
+    _byClientIndex.clear();
 }
 
-static std::string extractBlock(const std::string &src, const std::string &key, char open, char close) {
-    std::string marker = '"' + key + '"';
-    size_t p = src.find(marker);
-    if (p == std::string::npos) return {};
-    p = src.find(open, p);
-    if (p == std::string::npos) return {};
-    int d = 0;
-    for (size_t i = p; i < src.size(); ++i) {
-        if (src[i] == open) d++;
-        else if (src[i] == close) { d--; if (d == 0) return src.substr(p, i - p + 1); }
+void AccountAllOrdersWS::eraseLocked(size_t slot) {
+    Order &victim = _open[slot];
+    if (victim.order_index != 0) _byOrderIndex.erase(victim.order_index);
+    if (victim.client_order_index != 0) _byClientIndex.erase(victim.client_order_index);
+    const size_t last = _open.size() - 1;
+    if (slot != last) {
+        victim = _open[last];
+        _details[slot] = std::move(_details[last]);
+        if (victim.order_index != 0) _byOrderIndex[victim.order_index] = slot;
+        if (victim.client_order_index != 0) _byClientIndex[victim.client_order_index] = slot;
     }
-    return {};
+    _open.pop_back();
+    _details.pop_back();
 }
 
-// парсер
-void AccountAllOrdersWS::handleMessage(const std::string &json) {
-    if (json.find("\"type\":\"update/account_all_orders\"") == std::string::npos) return;
-    std::unordered_map<int, std::vector<Order>> newMap;
-    std::string ordersObj = extractBlock(json, "orders", '{', '}');
-    size_t cur = 0;
-    while (true) {
-        size_t keyQ1 = ordersObj.find('"', cur);
-        if (keyQ1 == std::string::npos) break;
-        size_t keyQ2 = ordersObj.find('"', keyQ1 + 1);
-        if (keyQ2 == std::string::npos) break;
-        std::string keyStr = ordersObj.substr(keyQ1 + 1, keyQ2 - keyQ1 - 1);
-        int market = std::atoi(keyStr.c_str());
-        size_t arrStart = ordersObj.find('[', keyQ2);
-        if (arrStart == std::string::npos) break;
-        int d = 0; size_t arrEnd = std::string::npos;
-        for (size_t i = arrStart; i < ordersObj.size(); ++i) {
-            if (ordersObj[i] == '[') d++;
-            else if (ordersObj[i] == ']') { d--; if (d == 0) { arrEnd = i; break; } }
-        }
-        if (arrEnd == std::string::npos) break;
-        std::string arr = ordersObj.substr(arrStart, arrEnd - arrStart + 1);
-        size_t p = 0; std::vector<Order> list;
-        while (true) {
-            size_t oStart = arr.find('{', p);
-            if (oStart == std::string::npos) break;
-            int dd = 0; size_t oEnd = std::string::npos;
-            for (size_t i = oStart; i < arr.size(); ++i) {
-                if (arr[i] == '{') dd++; else if (arr[i] == '}') { dd--; if (dd == 0) { oEnd = i; break; } }
-            }
-            if (oEnd == std::string::npos) break;
-            std::string o = arr.substr(oStart, oEnd - oStart + 1);
-
-            auto getString = [&](const char* key)->std::string{
-                std::string mk = std::string("\"") + key + "\"";
-                size_t p = o.find(mk); if (p == std::string::npos) return {};
-                p = o.find(':', p); if (p == std::string::npos) return {};
-                size_t q1 = o.find('"', p); if (q1 == std::string::npos) return {};
-                size_t q2 = o.find('"', q1 + 1); if (q2 == std::string::npos) return {};
-                return o.substr(q1 + 1, q2 - q1 - 1);
-            };
-            auto getInt = [&](const char* key)->long long{
-                std::string mk = std::string("\"") + key + "\"";
-                size_t p = o.find(mk); if (p == std::string::npos) return 0;
-                p = o.find(':', p); if (p == std::string::npos) return 0;
-                ++p; while (p < o.size() && (o[p]==' '||o[p]=='\t')) ++p;
-                return std::strtoll(o.c_str()+p, nullptr, 10);
-            };
-            auto getBool = [&](const char* key)->bool{
-                std::string mk = std::string("\"") + key + "\"";
-                size_t p = o.find(mk); if (p == std::string::npos) return false;
-                p = o.find(':', p); if (p == std::string::npos) return false;
-                ++p; while (p < o.size() && (o[p]==' '||o[p]=='\t')) ++p;
-                return o.compare(p, 4, "true") == 0;
-            };
-
-            Order ord;
-            ord.order_index = getInt("order_index");
-            ord.client_order_index = getInt("client_order_index");
-            ord.order_id = getString("order_id");
-            ord.client_order_id = getString("client_order_id");
-            ord.market_index = (int)getInt("market_index");
-            ord.owner_account_index = (int)getInt("owner_account_index");
-            ord.initial_base_amount = getString("initial_base_amount");
-            ord.price = getString("price");
-            ord.nonce = getInt("nonce");
-            ord.remaining_base_amount = getString("remaining_base_amount");
-            ord.is_ask = getBool("is_ask");
-            ord.filled_base_amount = getString("filled_base_amount");
-            ord.filled_quote_amount = getString("filled_quote_amount");
-            ord.side = getString("side");
-            ord.type = getString("type");
-            ord.time_in_force = getString("time_in_force");
-            ord.reduce_only = getBool("reduce_only");
-            ord.trigger_price = getString("trigger_price");
-            ord.order_expiry = getInt("order_expiry");
-            ord.status = getString("status");
-            ord.trigger_status = getString("trigger_status");
-            ord.trigger_time = getInt("trigger_time");
-            ord.parent_order_index = getInt("parent_order_index");
-            ord.parent_order_id = getString("parent_order_id");
-            ord.to_trigger_order_id_0 = getString("to_trigger_order_id_0");
-            ord.to_trigger_order_id_1 = getString("to_trigger_order_id_1");
-            ord.to_cancel_order_id_0 = getString("to_cancel_order_id_0");
-            ord.block_height = getInt("block_height");
-            ord.timestamp = getInt("timestamp");
-
-            list.push_back(std::move(ord));
-            p = oEnd + 1;
+void AccountAllOrdersWS::applyLocked(const Order &o, OrderDetails &&details) {
+    // сначала по order_index; ордер, известный только по client_order_index, получает его здесь
+    std::optional<size_t> slot;
+    if (o.order_index != 0) {
+        if (auto it = _byOrderIndex.find(o.order_index); it != _byOrderIndex.end()) slot = it->second;
+    }
+    if (!slot && o.client_order_index != 0) {
+        if (auto it = _byClientIndex.find(o.client_order_index); it != _byClientIndex.end()) slot = it->second;
+    }
+
+    if (o.isTerminal()) {
+        if (slot) eraseLocked(*slot);
+        return;
+    }
+    if (!slot) {
+        slot = _open.size();
+        _open.push_back(o);
+        _details.push_back(std::move(details));
+    } else {
+        Order &cur = _open[*slot];
+        if (cur.order_index != o.order_index && cur.order_index != 0) _byOrderIndex.erase(cur.order_index);
+        if (cur.client_order_index != o.client_order_index && cur.client_order_index != 0) {
+            _byClientIndex.erase(cur.client_order_index);
         }
-        newMap[market] = std::move(list);
-        cur = arrEnd + 1;
+        cur = o;
+        _details[*slot] = std::move(details);
     }
+    if (o.order_index != 0) _byOrderIndex[o.order_index] = *slot;
+    if (o.client_order_index != 0) _byClientIndex[o.client_order_index] = *slot;
+}
 
+// парсер: сообщение проходится один раз, без копий блоков
+void AccountAllOrdersWS::handleMessage(std::string_view json) {
+    AccountOrdersFrame &frame = *_frame;
+    const bool ok = parseAccountOrdersFrame(json, _cfg.priceScale, _cfg.sizeScale, frame);
+    if (frame.kind == AccountOrdersFrame::Kind::Other) return;
+    if (!ok) {
+        // битый кадр не применяем частично, но и пропустить его нельзя — в нём могли быть исполнения.
+        // Новая сессия подпишется заново, и снимок при подписке заменит хранилище целиком
+        _supervisor->reconnect("malformed orders message");
+        return;
+    }
+
+    _vanished.clear();
     {
         std::lock_guard<std::mutex> lk(_mtx);
-        _ordersByMarket = std::move(newMap);
+        const bool snapshot = frame.kind == AccountOrdersFrame::Kind::Snapshot;
+        if (snapshot) {
+            _vanished.swap(_open); // прежние открытые — сверим со снимком ниже
+            resetLocked();
+        }
+        for (size_t i = 0; i < frame.orders.size(); ++i) applyLocked(frame.orders[i], std::move(frame.details[i]));
+        if (snapshot) collectVanishedLocked();
     }
-    if (_cfg.onOrdersUpdated) _cfg.onOrdersUpdated(getOrders());
+    if (!_cfg.onOrdersChanged) return;
+    // исчезнувшие — первыми: подписчик должен узнать, что ордер закрылся, пока нас не было
+    if (!_vanished.empty()) _cfg.onOrdersChanged(_vanished);
+    if (!frame.orders.empty()) _cfg.onOrdersChanged(frame.orders);
 }
 
-void AccountAllOrdersWS::run() {
-    WsClient::Config wcfg;
-    wcfg.url = _cfg.url;
-    wcfg.extraHeaders = _cfg.extraHeaders;
-    if (!_cfg.authToken.empty()) wcfg.extraHeaders.emplace_back(std::string("Authorization: Bearer ") + _cfg.authToken);
-    wcfg.initialText = buildSubscribe(_cfg.accountId, _cfg.authToken);
-    wcfg.onMessage = [this](const std::string &data){ handleMessage(data); };
-    std::cout << "[AccountAllOrdersWS] starting: " << wcfg.url << " account=" << _cfg.accountId << std::endl;
-    WsClient ws(wcfg);
-    ws.start();
-    // Блокируем поток до stop(), без активных задержек
-    while (_running.load()) {
-        std::unique_lock<std::mutex> lk(_mtx);
-        if (!_running.load()) break;
-        lk.unlock();
-        std::this_thread::yield();
+void AccountAllOrdersWS::collectVanishedLocked() {
+    // ордер был открыт, а в снимке его нет — за время разрыва исполнен или снят. Чем именно, снимок
+    // не говорит: отдаём его закрытым (canceled) с последним известным исполнением
+    size_t kept = 0;
+    for (const Order &o : _vanished) {
+        const bool present = (o.order_index != 0 && _byOrderIndex.count(o.order_index)) ||
+                             (o.client_order_index != 0 && _byClientIndex.count(o.client_order_index));
+        if (present) continue;
+        Order &gone = _vanished[kept++];
+        gone = o;
+        gone.status = Status::Canceled;
+    }
+    _vanished.resize(kept);
+    if (kept > 0) {
+        std::cerr << "[AccountAllOrdersWS] " << kept << " open orders missing from snapshot, reported closed" << std::endl;
     }
-    std::cout << "[AccountAllOrdersWS] stopped" << std::endl;
 }
-
-
@@ -1,50 +1,78 @@
 #pragma once
 
 #include <string>
-#include <thread>
+#include <string_view>
+#include <memory>
 #include <mutex>
 #include <atomic>
 #include <functional>
 #include <unordered_map>
 #include <vector>
+#include <optional>
+#include <cstdint>
 
-#include "WsClient.h"
+#include "WsSupervisor.h"
 
-// Поддержка канала account_all_orders/{ACCOUNT_ID}
+struct AccountOrdersFrame;
+
+// Поддержка канала account_all_orders/{ACCOUNT_ID}.
+// Открытые ордера хранятся инкрементально: каждое обновление применяется по order_index
+// (или client_order_index, пока биржа не присвоила order_index), подписчик получает только
+// изменившиеся ордера. Стоимость обновления — по размеру изменения, а не по числу ордеров.
+// Ордер в конечном статусе (filled/canceled/expired) отдаётся последний раз и удаляется.
+// Снимок после переподключения сверяется с хранилищем: открытый ордер, которого в снимке нет,
+// отдаётся подписчику закрытым (canceled) — иначе его конечный статус потерялся бы в разрыве.
 class AccountAllOrdersWS {
 public:
-    struct Order {
+    enum class Side : uint8_t { Buy, Sell };
+    enum class Status : uint8_t { Unknown, InProgress, Pending, Open, Filled, Canceled };
+    enum class Type : uint8_t { Unknown, Limit, Market, StopLoss, StopLossLimit, TakeProfit, TakeProfitLimit, Twap, TwapSub, Liquidation };
+    enum class TimeInForce : uint8_t { Unknown, GoodTillTime, ImmediateOrCancel, PostOnly };
+
+    // Горячая часть ордера — ровно кэш-линия, без строк и аллокаций.
+    // Цена в тиках (priceScale), объёмы в лотах (sizeScale) — те же целые, что у стакана и signer
+    struct alignas(64) Order {
         long long order_index{0};
         long long client_order_index{0};
+        long long price{0};
+        long long initial_base_amount{0};
+        long long remaining_base_amount{0};
+        long long filled_base_amount{0};
+        long long timestamp{0};
+        int market_index{0};
+        Side side{Side::Buy};
+        Status status{Status::Unknown};
+        Type type{Type::Unknown};
+        TimeInForce time_in_force{TimeInForce::Unknown};
+
+        bool isAsk() const { return side == Side::Sell; }
+        bool isFilled() const { return status == Status::Filled; }
+        // filled/canceled*: больше не изменится
+        bool isTerminal() const { return status == Status::Filled || status == Status::Canceled; }
+    };
+    static_assert(sizeof(Order) == 64, "Order должен занимать одну кэш-линию");
+
+    // Редко нужные поля — отдельно от горячей записи, только по запросу (findOrderDetails)
+    struct OrderDetails {
         std::string order_id;
         std::string client_order_id;
-        int market_index{0};
-        int owner_account_index{0};
-        std::string initial_base_amount;
-        std::string price;
-        long long nonce{0};
-        std::string remaining_base_amount;
-        bool is_ask{false};
-        int base_size{0};
-        int base_price{0};
-        std::string filled_base_amount;
+        std::string status;            // как прислала биржа, с причиной отмены (canceled-post-only, ...)
         std::string filled_quote_amount;
-        std::string side;
-        std::string type;
-        std::string time_in_force;
-        bool reduce_only{false};
-        std::string trigger_price;
-        long long order_expiry{0};
-        std::string status;
         std::string trigger_status;
-        long long trigger_time{0};
-        long long parent_order_index{0};
         std::string parent_order_id;
         std::string to_trigger_order_id_0;
         std::string to_trigger_order_id_1;
         std::string to_cancel_order_id_0;
+        long long trigger_price{0};    // тики
+        long long nonce{0};
+        long long order_expiry{0};
+        long long trigger_time{0};
+        long long parent_order_index{0};
         long long block_height{0};
-        long long timestamp{0};
+        int owner_account_index{0};
+        int base_size{0};
+        int base_price{0};
+        bool reduce_only{false};
     };
 
     struct Config {
@@ -52,7 +80,11 @@ public:
         std::string accountId;
         std::string authToken;
         std::vector<std::string> extraHeaders;
-        std::function<void(const std::unordered_map<int, std::vector<Order>>&)> onOrdersUpdated;
+        long long priceScale{1}; // цена -> тики
+        long long sizeScale{1};  // объём -> лоты
+        // Ордера, изменившиеся в этом сообщении (снимок при подписке — все, и перед ними отдельным вызовом
+        // исчезнувшие из него). Зовётся в потоке сокета
+        std::function<void(const std::vector<Order>&)> onOrdersChanged;
     };
 
     explicit AccountAllOrdersWS(Config cfg);
@@ -61,19 +93,36 @@ public:
     void start();
     void stop();
 
+    // Копия открытых ордеров по рынкам — O(всех ордеров), не для горячего пути
     std::unordered_map<int, std::vector<Order>> getOrders() const;
+    std::optional<Order> findOrder(long long orderIndex) const;
+    std::optional<OrderDetails> findOrderDetails(long long orderIndex) const;
+    size_t openOrderCount() const;
+    WsSupervisor::Stats connectionStats() const { return _supervisor->stats(); }
 
 private:
-    void run();
-    void handleMessage(const std::string &json);
+    void handleMessage(std::string_view json);
     static std::string buildSubscribe(const std::string &accountId, const std::string &auth);
 
+    // под _mtx
+    void resetLocked();
+    void applyLocked(const Order &o, OrderDetails &&details);
+    void eraseLocked(size_t slot);
+    // _vanished — прежние открытые; оставить в нём отсутствующие в новом хранилище, закрытыми
+    void collectVanishedLocked();
+
     Config _cfg;
-    std::thread _thr;
     std::atomic<bool> _running{false};
+    std::unique_ptr<WsSupervisor> _supervisor;
+    std::unique_ptr<AccountOrdersFrame> _frame; // разбор сообщений, только поток сокета
+    std::vector<Order> _vanished; // исчезнувшие при снимке, только поток сокета; ёмкость переиспользуется
 
     mutable std::mutex _mtx;
-    std::unordered_map<int, std::vector<Order>> _ordersByMarket;
+    // Плотный массив открытых ордеров; удаление — перестановкой последнего на место удалённого
+    std::vector<Order> _open;
+    std::vector<OrderDetails> _details; // тот же слот, что в _open
+    std::unordered_map<long long, size_t> _byOrderIndex;
+    std::unordered_map<long long, size_t> _byClientIndex;
 };
 
 
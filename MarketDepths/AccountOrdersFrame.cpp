@@ -0,0 +1,149 @@
+#include "AccountOrdersFrame.h"
+
+#include "FixedPoint.h"
+#include "JsonScan.h"
+
+void AccountOrdersFrame::clear() {
+    kind = Kind::Other;
+    orders.clear();
+    details.clear();
+}
+
+// Строковые поля биржи -> enum; неизвестное — Unknown, ордер всё равно учитывается
+static AccountAllOrdersWS::Status parseStatus(std::string_view s) {
+    using S = AccountAllOrdersWS::Status;
+    if (s == "open") return S::Open;
+    if (s == "filled") return S::Filled;
+    if (s == "pending") return S::Pending;
+    if (s == "in-progress") return S::InProgress;
+    // canceled, canceled-post-only, canceled-expired, ... — причина остаётся в OrderDetails::status
+    if (s.rfind("canceled", 0) == 0 || s == "expired") return S::Canceled;
+    return S::Unknown;
+}
+
+static AccountAllOrdersWS::Type parseType(std::string_view s) {
+    using T = AccountAllOrdersWS::Type;
+    if (s == "limit") return T::Limit;
+    if (s == "market") return T::Market;
+    if (s == "stop-loss") return T::StopLoss;
+    if (s == "stop-loss-limit") return T::StopLossLimit;
+    if (s == "take-profit") return T::TakeProfit;
+    if (s == "take-profit-limit") return T::TakeProfitLimit;
+    if (s == "twap") return T::Twap;
+    if (s == "twap-sub") return T::TwapSub;
+    if (s == "liquidation") return T::Liquidation;
+    return T::Unknown;
+}
+
+static AccountAllOrdersWS::TimeInForce parseTimeInForce(std::string_view s) {
+    using F = AccountAllOrdersWS::TimeInForce;
+    if (s == "good-till-time") return F::GoodTillTime;
+    if (s == "immediate-or-cancel") return F::ImmediateOrCancel;
+    if (s == "post-only") return F::PostOnly;
+    return F::Unknown;
+}
+
+// Один проход по объекту ордера: ключ -> switch по хешу -> поле. Горячая запись заполняется
+// без аллокаций; строки уходят только в OrderDetails (id обычно влезают в SSO)
+static bool parseOrder(jsonscan::Cursor &c, long long priceScale, long long sizeScale,
+                       AccountAllOrdersWS::Order &ord, AccountAllOrdersWS::OrderDetails &det) {
+    using namespace jsonscan;
+    return forEachMember(c, [&](std::string_view key, Cursor &v) {
+        std::string_view tok;
+        // числа: null — поля нет (остаётся 0); нечисловое значение бракует весь кадр, а не молча
+        // оставляет 0 в цене или объёме — владелец переподключится и получит свежий снимок
+        auto intField = [&](long long &out) {
+            if (!readScalar(v, tok)) return false;
+            return tok == "null" || parseInt(tok, out);
+        };
+        auto int32Field = [&](int &out) {
+            long long x = 0;
+            if (!intField(x)) return false;
+            out = (int) x;
+            return true;
+        };
+        auto fixedField = [&](long long scale, long long &out) {
+            if (!readScalar(v, tok)) return false;
+            return tok == "null" || fixedpoint::parseDecimal(tok, scale, out);
+        };
+        auto stringField = [&](std::string &out) {
+            if (!readScalar(v, tok)) return false;
+            out.assign(tok.data(), tok.size());
+            return true;
+        };
+        auto boolField = [&](bool &out) {
+            if (!readScalar(v, tok)) return false;
+            out = tok == "true";
+            return true;
+        };
+        auto enumField = [&](auto parse, auto &out) {
+            if (!readScalar(v, tok)) return false;
+            out = parse(tok);
+            return true;
+        };
+
+        switch (keyHash(key)) {
+// case по хешу + сверка самого ключа; чужой ключ уходит в skipValue
+#define ORDER_FIELD(name, ...) case keyHash(name): if (key != name) break; return __VA_ARGS__;
+            ORDER_FIELD("order_index", intField(ord.order_index))
+            ORDER_FIELD("client_order_index", intField(ord.client_order_index))
+            ORDER_FIELD("market_index", int32Field(ord.market_index))
+            ORDER_FIELD("price", fixedField(priceScale, ord.price))
+            ORDER_FIELD("initial_base_amount", fixedField(sizeScale, ord.initial_base_amount))
+            ORDER_FIELD("remaining_base_amount", fixedField(sizeScale, ord.remaining_base_amount))
+            ORDER_FIELD("filled_base_amount", fixedField(sizeScale, ord.filled_base_amount))
+            ORDER_FIELD("timestamp", intField(ord.timestamp))
+            ORDER_FIELD("is_ask", enumField([](std::string_view t) {
+                return t == "true" ? AccountAllOrdersWS::Side::Sell : AccountAllOrdersWS::Side::Buy;
+            }, ord.side))
+            ORDER_FIELD("status", stringField(det.status) && ((ord.status = parseStatus(det.status)), true))
+            ORDER_FIELD("type", enumField(parseType, ord.type))
+            ORDER_FIELD("time_in_force", enumField(parseTimeInForce, ord.time_in_force))
+            ORDER_FIELD("order_id", stringField(det.order_id))
+            ORDER_FIELD("client_order_id", stringField(det.client_order_id))
+            ORDER_FIELD("filled_quote_amount", stringField(det.filled_quote_amount))
+            ORDER_FIELD("trigger_status", stringField(det.trigger_status))
+            ORDER_FIELD("parent_order_id", stringField(det.parent_order_id))
+            ORDER_FIELD("to_trigger_order_id_0", stringField(det.to_trigger_order_id_0))
+            ORDER_FIELD("to_trigger_order_id_1", stringField(det.to_trigger_order_id_1))
+            ORDER_FIELD("to_cancel_order_id_0", stringField(det.to_cancel_order_id_0))
+            ORDER_FIELD("trigger_price", fixedField(priceScale, det.trigger_price))
+            ORDER_FIELD("nonce", intField(det.nonce))
+            ORDER_FIELD("order_expiry", intField(det.order_expiry))
+            ORDER_FIELD("trigger_time", intField(det.trigger_time))
+            ORDER_FIELD("parent_order_index", intField(det.parent_order_index))
+            ORDER_FIELD("block_height", intField(det.block_height))
+            ORDER_FIELD("owner_account_index", int32Field(det.owner_account_index))
+            ORDER_FIELD("base_size", int32Field(det.base_size))
+            ORDER_FIELD("base_price", int32Field(det.base_price))
+            ORDER_FIELD("reduce_only", boolField(det.reduce_only))
+#undef ORDER_FIELD
+            default:
+                break;
+        }
+        return skipValue(v);
+    });
+}
+
+bool parseAccountOrdersFrame(std::string_view json, long long priceScale, long long sizeScale, AccountOrdersFrame &out) {
+    using namespace jsonscan;
+    out.clear();
+    // subscribed/... — полный снимок (в том числе после переподключения), update/... — только изменения
+    std::string_view type;
+    Cursor c(json);
+    const bool ok = forEachMember(c, [&](std::string_view key, Cursor &v) {
+        if (key == "type") return readString(v, type);
+        if (key != "orders") return skipValue(v);
+        // {"<market>": [ {order}, ... ], ...}
+        return forEachMember(v, [&](std::string_view, Cursor &mc) {
+            return forEachElement(mc, [&](Cursor &oc) {
+                AccountAllOrdersWS::Order &ord = out.orders.emplace_back();
+                AccountAllOrdersWS::OrderDetails &det = out.details.emplace_back();
+                return parseOrder(oc, priceScale, sizeScale, ord, det);
+            });
+        });
+    });
+    if (type == "subscribed/account_all_orders") out.kind = AccountOrdersFrame::Kind::Snapshot;
+    else if (type == "update/account_all_orders") out.kind = AccountOrdersFrame::Kind::Update;
+    return ok;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "AccountAllOrdersWS.h"
+
+// Разобранное сообщение канала account_all_orders/{ACCOUNT_ID}. Векторы переиспользуются
+// между кадрами; строки OrderDetails забирает хранилище ордеров.
+struct AccountOrdersFrame {
+    enum class Kind { Other, Snapshot, Update };
+
+    Kind kind{Kind::Other};
+    std::vector<AccountAllOrdersWS::Order> orders;
+    std::vector<AccountAllOrdersWS::OrderDetails> details; // параллельно orders
+
+    void clear();
+};
+
+// Один проход по сообщению: тип и все ордера сразу в тики/лоты.
+// false — сообщение не JSON-объект или один из ордеров битый (кадр целиком не годится).
+bool parseAccountOrdersFrame(std::string_view json, long long priceScale, long long sizeScale, AccountOrdersFrame &out);
@@ -0,0 +1,47 @@
+#include "DepthSeqLock.h"
+
+#include <algorithm>
+#include <thread>
+
+void DepthSeqLock::publish(const MarketDepth &depth, long long offset) {
+    const uint64_t s = _seq.load(std::memory_order_relaxed);
+    _seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    _priceScale = depth.priceScale;
+    _sizeScale = depth.sizeScale;
+    _offset = offset;
+    _bidCount = std::min(depth.bids.size(), kMaxLevels);
+    _askCount = std::min(depth.asks.size(), kMaxLevels);
+    std::copy_n(depth.bids.begin(), _bidCount, _bids);
+    std::copy_n(depth.asks.begin(), _askCount, _asks);
+
+    _seq.store(s + 2, std::memory_order_release);
+}
+
+bool DepthSeqLock::read(MarketDepth &out, long long *offset) const {
+    if (out.bids.capacity() < kMaxLevels) out.bids.reserve(kMaxLevels);
+    if (out.asks.capacity() < kMaxLevels) out.asks.reserve(kMaxLevels);
+    while (true) {
+        const uint64_t s1 = _seq.load(std::memory_order_acquire);
+        if (s1 == 0) return false;
+        if (s1 & 1) {
+            std::this_thread::yield(); // писатель посреди копирования, это десятки наносекунд
+            continue;
+        }
+        // счётчики могли прочитаться рваными — ограничиваем, проверка seq ниже отбросит такую копию
+        const size_t nb = std::min(_bidCount, kMaxLevels);
+        const size_t na = std::min(_askCount, kMaxLevels);
+        out.priceScale = _priceScale;
+        out.sizeScale = _sizeScale;
+        out.bids.assign(_bids, _bids + nb);
+        out.asks.assign(_asks, _asks + na);
+        const long long off = _offset;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_seq.load(std::memory_order_relaxed) == s1) {
+            if (offset) *offset = off;
+            return true;
+        }
+    }
+}
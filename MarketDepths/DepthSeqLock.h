@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "MarketDepth.h"
+
+// Публикация стакана одним писателем многим читателям без блокировок (seqlock).
+// Книга хранится в массивах фиксированной ёмкости: publish/read не аллоцируют и не берут мьютексов,
+// читатель просто перечитывает, если попал на запись.
+class DepthSeqLock {
+public:
+    static constexpr size_t kMaxLevels = 64; // глубже всё равно режем depthLimit
+
+    // Только из одного потока (поток фида). Уровни глубже kMaxLevels отбрасываются.
+    void publish(const MarketDepth &depth, long long offset);
+
+    // Согласованная копия в out. Ёмкость out резервируется один раз, дальше без аллокаций.
+    // false — ещё ничего не опубликовано.
+    bool read(MarketDepth &out, long long *offset = nullptr) const;
+
+    // Растёт с каждой публикацией, 0 — публикаций не было
+    uint64_t version() const { return _seq.load(std::memory_order_acquire) / 2; }
+
+private:
+    std::atomic<uint64_t> _seq{0}; // нечётное — идёт запись
+    long long _priceScale{1};
+    long long _sizeScale{1};
+    long long _offset{-1};
+    size_t _bidCount{0};
+    size_t _askCount{0};
+    PriceLevel _bids[kMaxLevels];
+    PriceLevel _asks[kMaxLevels];
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cmath>
+#include <string_view>
+
+// Цены и объёмы храним целыми числами:
+//   price_ticks = price * priceScale, size_lots = size * sizeScale.
+// Скейлы те же, что уходят в signer (LighterRequests::setSignerConfig), поэтому
+// целое из стакана можно сразу подписывать без float-округлений.
+namespace fixedpoint {
+
+// Разбор десятичной строки ("0.47937", "-12.5", "100") сразу в целое со скейлом.
+// Если знаков больше, чем позволяет скейл, — округление к ближайшему. false — если это не число.
+inline bool parseDecimal(std::string_view s, long long scale, long long &out) {
+    size_t i = 0;
+    bool neg = false;
+    if (i < s.size() && (s[i] == '-' || s[i] == '+')) { neg = s[i] == '-'; ++i; }
+    long long intPart = 0;
+    size_t digits = 0;
+    while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+        intPart = intPart * 10 + (s[i] - '0');
+        ++i; ++digits;
+    }
+    long long frac = 0;
+    long long fracDiv = 1;
+    if (i < s.size() && s[i] == '.') {
+        ++i;
+        int taken = 0;
+        while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+            if (taken < 18) {
+                frac = frac * 10 + (s[i] - '0');
+                fracDiv *= 10;
+                ++taken;
+            }
+            ++i; ++digits;
+        }
+    }
+    if (digits == 0) return false;
+    long long v = intPart * scale;
+    if (frac != 0) {
+        if (scale % fracDiv == 0) v += frac * (scale / fracDiv);  // обычный случай: хватает точности скейла
+        else v += (long long)std::llround((long double)frac * (long double)scale / (long double)fracDiv);
+    }
+    out = neg ? -v : v;
+    return true;
+}
+
+inline long long fromDouble(double v, long long scale) { return (long long)std::llround(v * (double)scale); }
+inline double toDouble(long long v, long long scale) { return scale > 0 ? (double)v / (double)scale : 0.0; }
+
+} // namespace fixedpoint
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Однопроходный разбор JSON поверх string_view: без копий, без аллокаций.
+// Значения отдаются как срезы исходного текста, поэтому живут не дольше самого сообщения.
+// Строки с escape-последовательностями не раскодируются — для наших полей (числа, id, типы) это не нужно.
+namespace jsonscan {
+
+struct Cursor {
+    const char *p;
+    const char *end;
+
+    explicit Cursor(std::string_view s) : p(s.data()), end(s.data() + s.size()) {}
+    bool atEnd() const { return p >= end; }
+};
+
+inline void skipWs(Cursor &c) {
+    while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\n' || *c.p == '\r')) ++c.p;
+}
+
+inline bool consume(Cursor &c, char ch) {
+    skipWs(c);
+    if (c.p < c.end && *c.p == ch) { ++c.p; return true; }
+    return false;
+}
+
+// "..." -> содержимое без кавычек
+inline bool readString(Cursor &c, std::string_view &out) {
+    skipWs(c);
+    if (c.p >= c.end || *c.p != '"') return false;
+    const char *b = ++c.p;
+    while (c.p < c.end && *c.p != '"') {
+        if (*c.p == '\\') ++c.p;
+        ++c.p;
+    }
+    if (c.p >= c.end) return false;
+    out = std::string_view(b, (size_t)(c.p - b));
+    ++c.p;
+    return true;
+}
+
+// число / true / false / null как сырой токен
+inline bool readLiteral(Cursor &c, std::string_view &out) {
+    skipWs(c);
+    const char *b = c.p;
+    while (c.p < c.end && *c.p != ',' && *c.p != '}' && *c.p != ']' &&
+           *c.p != ' ' && *c.p != '\t' && *c.p != '\n' && *c.p != '\r') ++c.p;
+    if (c.p == b) return false;
+    out = std::string_view(b, (size_t)(c.p - b));
+    return true;
+}
+
+// Скаляр любого вида: строка отдаётся без кавычек, число — как есть
+inline bool readScalar(Cursor &c, std::string_view &out) {
+    skipWs(c);
+    if (c.p < c.end && *c.p == '"') return readString(c, out);
+    return readLiteral(c, out);
+}
+
+inline bool parseInt(std::string_view s, long long &out) {
+    size_t i = 0;
+    bool neg = false;
+    if (i < s.size() && (s[i] == '-' || s[i] == '+')) { neg = s[i] == '-'; ++i; }
+    if (i >= s.size()) return false;
+    long long v = 0;
+    for (; i < s.size(); ++i) {
+        if (s[i] < '0' || s[i] > '9') break;
+        v = v * 10 + (s[i] - '0');
+    }
+    out = neg ? -v : v;
+    return true;
+}
+
+inline bool readInt(Cursor &c, long long &out) {
+    std::string_view tok;
+    return readScalar(c, tok) && parseInt(tok, out);
+}
+
+inline bool readBool(Cursor &c, bool &out) {
+    std::string_view tok;
+    if (!readLiteral(c, tok)) return false;
+    out = tok == "true";
+    return true;
+}
+
+// Пропустить значение целиком (включая вложенные объекты/массивы)
+inline bool skipValue(Cursor &c) {
+    skipWs(c);
+    if (c.p >= c.end) return false;
+    if (*c.p == '"') { std::string_view s; return readString(c, s); }
+    if (*c.p != '{' && *c.p != '[') { std::string_view s; return readLiteral(c, s); }
+    int depth = 0;
+    while (c.p < c.end) {
+        const char ch = *c.p;
+        if (ch == '"') {
+            std::string_view s;
+            if (!readString(c, s)) return false;
+            continue;
+        }
+        if (ch == '{' || ch == '[') ++depth;
+        else if (ch == '}' || ch == ']') {
+            if (--depth == 0) { ++c.p; return true; }
+        }
+        ++c.p;
+    }
+    return false;
+}
+
+// FNV-1a ключа — constexpr, чтобы диспетчер полей был switch по константам:
+// switch (keyHash(key)) { case keyHash("price"): ... }. Совпадение двух известных ключей —
+// ошибка компиляции (повтор case); чужой ключ с тем же хешем отсекается сравнением в case
+constexpr uint64_t keyHash(std::string_view s) {
+    uint64_t h = 1469598103934665603ull;
+    for (char ch : s) {
+        h ^= (unsigned char) ch;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Обход объекта: onMember(key, cursor) обязан прочитать или пропустить значение и вернуть true
+template <typename F>
+bool forEachMember(Cursor &c, F &&onMember) {
+    if (!consume(c, '{')) return false;
+    if (consume(c, '}')) return true;
+    while (true) {
+        std::string_view key;
+        if (!readString(c, key)) return false;
+        if (!consume(c, ':')) return false;
+        if (!onMember(key, c)) return false;
+        if (consume(c, ',')) continue;
+        return consume(c, '}');
+    }
+}
+
+// Обход массива: onElement(cursor) обязан прочитать или пропустить элемент
+template <typename F>
+bool forEachElement(Cursor &c, F &&onElement) {
+    if (!consume(c, '[')) return false;
+    if (consume(c, ']')) return true;
+    while (true) {
+        if (!onElement(c)) return false;
+        if (consume(c, ',')) continue;
+        return consume(c, ']');
+    }
+}
+
+} // namespace jsonscan
@@ -1,14 +1,16 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <thread>
-#include <mutex>
 #include <atomic>
-#include <optional>
+#include <memory>
 #include <functional>
 #include "MarketDepth.h"
-#include "WsClient.h"
+#include "OrderBookFrame.h"
+#include "DepthSeqLock.h"
+#include "OrderBookSync.h"
+#include "WsSupervisor.h"
 
 class LighterOrderBookWS {
 public:
@@ -17,9 +19,17 @@ public:
         std::string subscribeJson;
         std::vector<std::string> extraHeaders;
         std::string symbol;
+        std::string channel; // order_book/{symbol}, если пусто
         int depthLimit = 50;
-        std::function<void(const std::string&)> onMessage; // колбэк для сырых сообщений
-		std::function<void(const MarketDepth&, long long)> onDepthUpdated; // вызывается после каждого обновления стакана (depth, offset)
+        int resyncTimeoutMs = 2000;
+        size_t maxBufferedDeltas = 4096;
+        // Скейлы цены/объёма рынка (как в LighterRequests::setSignerConfig), 1 — целые числа
+        long long priceScale = 1;
+        long long sizeScale = 1;
+        std::function<void(std::string_view)> onMessage; // колбэк для сырых сообщений, срез живёт только на время вызова
+		// вызывается после каждого обновления стакана (depth, offset) прямо из потока фида;
+		// ссылка валидна только на время вызова, копия — забота подписчика
+		std::function<void(const MarketDepth&, long long)> onDepthUpdated;
     };
 
     explicit LighterOrderBookWS(Config cfg);
@@ -28,26 +38,30 @@ public:
     void start();
     void stop();
 
+    // Копия последней опубликованной книги (аллоцирует, для редких вызовов)
     MarketDepth getSnapshot() const;
+    // То же без аллокаций и блокировок: out переиспользуется вызывающим
+    bool readDepth(MarketDepth &out, long long *offset = nullptr) const { return _sync.published().read(out, offset); }
+    const DepthSeqLock &published() const { return _sync.published(); }
 
-private:
-    void run();
-    void parseAndUpdate(const std::string &jsonText);
+    // Разрывы offset, переподписки и время восстановления книги
+    OrderBookSync::Stats syncStats() const { return _sync.stats(); }
+    // Переподключения и время без соединения
+    WsSupervisor::Stats connectionStats() const { return _supervisor->stats(); }
 
-    static std::vector<std::pair<float, float>> parseOrdersArray(const std::string &json, const std::string &key);
+private:
+    void parseAndUpdate(std::string_view jsonText);
+    void resubscribe();
 
     Config _cfg;
-    mutable std::mutex _mtx;
-    MarketDepth _depth;
-    std::thread _thr;
     std::atomic<bool> _running{false};
 
-    // Состояние синхронизации актуального стакана
-    bool _hasSnapshot{false};
-    long long _lastOffset{-1};
+    // Книга, offset и ресинк
+    OrderBookSync _sync;
+    OrderBookFrame _frame; // буферы разбора, живут между кадрами
 
-    // Внутренний клиент WebSocket
-    WsClient *_ws{nullptr};
+    // Соединение, переподключения и повторная подписка
+    std::unique_ptr<WsSupervisor> _supervisor;
 };
 
 
@@ -3,93 +3,101 @@
 //
 
 #include "MarketDepth.h"
+#include "FixedPoint.h"
 #include <algorithm>
-#include <cmath>
 
-static inline bool floatEqual(float a, float b, float eps = 1e-6f) {
-    return std::fabs(a - b) <= eps * std::max(1.0f, std::max(std::fabs(a), std::fabs(b)));
-}
-
-static void sortDepth(std::vector<std::pair<float, float>> &bids,
-                      std::vector<std::pair<float, float>> &asks) {
+static void sortDepth(std::vector<PriceLevel> &bids,
+                      std::vector<PriceLevel> &asks) {
     // bids: по убыванию цены; asks: по возрастанию цены
     std::sort(bids.begin(), bids.end(), [](const auto &l, const auto &r) {
-        return l.first > r.first;
+        return l.price > r.price;
     });
     std::sort(asks.begin(), asks.end(), [](const auto &l, const auto &r) {
-        return l.first < r.first;
+        return l.price < r.price;
     });
 }
 
-static void applyEdits(std::vector<std::pair<float, float>> &levels,
-                       const std::vector<std::pair<float, float>> &edits) {
+// Уровни всегда отсортированы, поэтому правка — бинарный поиск + точечная вставка/удаление,
+// без полного пересорта. better(a, b) — a стоит в книге раньше b.
+template <typename Better>
+static void applyEdits(std::vector<PriceLevel> &levels,
+                       const std::vector<PriceLevel> &edits, Better better) {
     for (const auto &e : edits) {
-        const float price = e.first;
-        const float volume = e.second;
-        auto it = std::find_if(levels.begin(), levels.end(), [&](const auto &lvl) {
-            return floatEqual(lvl.first, price);
+        // цены целые — сравниваем точно, без допусков
+        auto it = std::lower_bound(levels.begin(), levels.end(), e.price, [&](const PriceLevel &lvl, long long px) {
+            return better(lvl.price, px);
         });
-        if (volume <= 0.0f) {
-            if (it != levels.end()) levels.erase(it);
+        const bool found = it != levels.end() && it->price == e.price;
+        if (e.size <= 0) {
+            if (found) levels.erase(it);
             continue;
         }
-        if (it != levels.end()) {
-            it->second = volume;
+        if (found) {
+            it->size = e.size;
         } else {
-            levels.emplace_back(price, volume);
+            levels.insert(it, e);
         }
     }
 }
 
-float MarketDepth::GetBestBidPriceFor(float targetVolume) const {
-    if (targetVolume <= 0.0f) return 0.0f;
-    float remaining = targetVolume;
-    float notional = 0.0;
-    for (const auto &lvl : bids) {
-        const float price = lvl.first;
-        const float volume = lvl.second;
-        if (volume <= 0.0f) continue;
-        const float take = volume < remaining ? volume : remaining;
-        notional += take * price;
+// Средняя цена исполнения targetLots по стороне, 0.0 если ликвидности не хватает
+static double averageFillPrice(const std::vector<PriceLevel> &levels, long long targetLots) {
+    if (targetLots <= 0) return 0.0;
+    long long remaining = targetLots;
+    double notional = 0.0; // в тиках * лоты
+    for (const auto &lvl : levels) {
+        if (lvl.size <= 0) continue;
+        const long long take = lvl.size < remaining ? lvl.size : remaining;
+        notional += (double)take * (double)lvl.price;
         remaining -= take;
-        if (remaining <= 0.0f) break;
+        if (remaining <= 0) break;
     }
-    if (remaining > 0.0f) return 0.0f; // не хватило ликвидности
-    return notional / targetVolume;
+    if (remaining > 0) return 0.0; // не хватило ликвидности
+    return notional / (double)targetLots;
+}
+
+MarketDepth::MarketDepth(long long priceScale, long long sizeScale)
+        : priceScale(priceScale > 0 ? priceScale : 1), sizeScale(sizeScale > 0 ? sizeScale : 1) {}
+
+double MarketDepth::toPrice(long long ticks) const { return fixedpoint::toDouble(ticks, priceScale); }
+double MarketDepth::toSize(long long lots) const { return fixedpoint::toDouble(lots, sizeScale); }
+long long MarketDepth::toTicks(double price) const { return fixedpoint::fromDouble(price, priceScale); }
+long long MarketDepth::toLots(double size) const { return fixedpoint::fromDouble(size, sizeScale); }
+
+long long MarketDepth::bidTicks(size_t i) const { return i < bids.size() ? bids[i].price : 0; }
+long long MarketDepth::askTicks(size_t i) const { return i < asks.size() ? asks[i].price : 0; }
+
+float MarketDepth::GetBestBidPriceFor(float targetVolume) const {
+    if (targetVolume <= 0.0f) return 0.0f;
+    return (float)(averageFillPrice(bids, toLots(targetVolume)) / (double)priceScale);
 }
 
 float MarketDepth::GetBestAskPriceFor(float targetVolume) const {
     if (targetVolume <= 0.0f) return 0.0f;
-    float remaining = targetVolume;
-    float notional = 0.0;
-    for (const auto &lvl : asks) {
-        const float price = lvl.first;
-        const float volume = lvl.second;
-        if (volume <= 0.0f) continue;
-        const float take = volume < remaining ? volume : remaining;
-        notional += take * price;
-        remaining -= take;
-        if (remaining <= 0.0f) break;
-    }
-    if (remaining > 0.0f) return 0.0f; // не хватило ликвидности
-    return notional / targetVolume;
+    return (float)(averageFillPrice(asks, toLots(targetVolume)) / (double)priceScale);
 }
 
-void MarketDepth::snapshot(std::vector<std::pair<float, float>> _bids,
-                           std::vector<std::pair<float, float>> _asks) {
+void MarketDepth::snapshot(const std::vector<PriceLevel> &_bids,
+                           const std::vector<PriceLevel> &_asks) {
     // Отфильтровать нулевые/отрицательные объёмы
     bids.clear();
     asks.clear();
     bids.reserve(_bids.size());
     asks.reserve(_asks.size());
-    for (const auto &v : _bids) if (v.second > 0.0f) bids.push_back(v);
-    for (const auto &v : _asks) if (v.second > 0.0f) asks.push_back(v);
+    for (const auto &v : _bids) if (v.size > 0) bids.push_back(v);
+    for (const auto &v : _asks) if (v.size > 0) asks.push_back(v);
     sortDepth(bids, asks);
 }
 
-void MarketDepth::update(std::vector<std::pair<float, float>> bidsEditions,
-                         std::vector<std::pair<float, float>> asksEditions) {
-    applyEdits(bids, bidsEditions);
-    applyEdits(asks, asksEditions);
-    sortDepth(bids, asks);
-}
\ No newline at end of file
+void MarketDepth::update(const std::vector<PriceLevel> &bidsEditions,
+                         const std::vector<PriceLevel> &asksEditions) {
+    // правки у верха книги — вставка сдвигает лишь хвост вектора, на глубине 50 это дешевле любого дерева
+    applyEdits(bids, bidsEditions, [](long long l, long long r) { return l > r; });
+    applyEdits(asks, asksEditions, [](long long l, long long r) { return l < r; });
+}
+
+void MarketDepth::truncate(size_t limit) {
+    if (limit == 0) return;
+    if (bids.size() > limit) bids.resize(limit);
+    if (asks.size() > limit) asks.resize(limit);
+}
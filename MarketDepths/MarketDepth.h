@@ -8,14 +8,37 @@
 #include <vector>
 #include <utility>
 
+// Уровень стакана в целых: цена в тиках (price * priceScale), объём в лотах (size * sizeScale)
+struct PriceLevel {
+    long long price{0};
+    long long size{0};
+};
 
 class MarketDepth {
 public:
-    std::vector<std::pair<float, float>> bids;
-    std::vector<std::pair<float, float>> asks;
+    std::vector<PriceLevel> bids; // по убыванию цены
+    std::vector<PriceLevel> asks; // по возрастанию цены
+
+    // Те же скейлы, что и в LighterRequests::setSignerConfig (priceScale / baseAmountScale)
+    long long priceScale{1};
+    long long sizeScale{1};
 
+    MarketDepth() = default;
+    MarketDepth(long long priceScale, long long sizeScale);
     ~MarketDepth() = default;
 
+    // float/double-слой поверх целых уровней
+    double toPrice(long long ticks) const;
+    double toSize(long long lots) const;
+    long long toTicks(double price) const;
+    long long toLots(double size) const;
+
+    // 0 / 0.0 если уровня нет
+    long long bidTicks(size_t i) const;
+    long long askTicks(size_t i) const;
+    double bidPrice(size_t i) const { return toPrice(bidTicks(i)); }
+    double askPrice(size_t i) const { return toPrice(askTicks(i)); }
+
     //  лучшая цена для исполнения указанного объёма
     // 0.0f если ликвидности не хватает
     float GetBestBidPriceFor(float targetVolume) const;
@@ -23,10 +46,14 @@ public:
     // 0.0f если ликвидности не хватает
     float GetBestAskPriceFor(float targetVolume) const;
 
-    void update(std::vector<std::pair<float, float>> bidsEditions, std::vector<std::pair<float, float>> asksEditions);
+    // O(log n) поиск уровня на каждую правку, книга остаётся отсортированной без пересорта
+    void update(const std::vector<PriceLevel> &bidsEditions, const std::vector<PriceLevel> &asksEditions);
+
+    void snapshot(const std::vector<PriceLevel> &_bids, const std::vector<PriceLevel> &_asks);
 
-    void snapshot(std::vector<std::pair<float, float>> _bids, std::vector<std::pair<float, float>> _asks);
+    // оставить только limit лучших уровней с каждой стороны (0 — без ограничения)
+    void truncate(size_t limit);
 };
 
 
-#endif //MM_BID_ASK_MARKETDEPTH_H
\ No newline at end of file
+#endif //MM_BID_ASK_MARKETDEPTH_H
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Ограниченная lock-free очередь: много писателей, один читатель (схема Вьюкова).
+// Слоты создаются один раз и переиспользуются: писатель заполняет значение на месте,
+// читатель забирает его на месте же — для std::string с заранее выделенной ёмкостью
+// это отправка без аллокаций. Ёмкость округляется вверх до степени двойки.
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity) : _mask(roundUp(capacity) - 1), _cells(new Cell[_mask + 1]) {
+        for (size_t i = 0; i <= _mask; ++i) _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing &) = delete;
+    MpscRing &operator=(const MpscRing &) = delete;
+
+    size_t capacity() const { return _mask + 1; }
+
+    // Только до начала работы: например, зарезервировать ёмкость строк
+    template <typename F>
+    void forEachSlot(F &&f) {
+        for (size_t i = 0; i <= _mask; ++i) f(_cells[i].value);
+    }
+
+    // Любой поток. fill(T&) заполняет слот; false — очередь полна, fill не вызывался
+    template <typename F>
+    bool tryPush(F &&fill) {
+        size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &_cells[pos & _mask];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Только поток-читатель. take(T&) забирает значение; false — очередь пуста
+    template <typename F>
+    bool tryPop(F &&take) {
+        Cell *cell = &_cells[_dequeuePos & _mask];
+        const size_t seq = cell->seq.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(_dequeuePos + 1) < 0) return false;
+        take(cell->value);
+        cell->seq.store(_dequeuePos + _mask + 1, std::memory_order_release);
+        ++_dequeuePos;
+        return true;
+    }
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<size_t> seq{0};
+        T value{};
+    };
+
+    static size_t roundUp(size_t n) {
+        size_t c = 2;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    const size_t _mask;
+    std::unique_ptr<Cell[]> _cells;
+    alignas(64) std::atomic<size_t> _enqueuePos{0};
+    alignas(64) size_t _dequeuePos{0}; // только читатель
+};
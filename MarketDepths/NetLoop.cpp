@@ -0,0 +1,73 @@
+#include "NetLoop.h"
+
+#include <algorithm>
+#include <iostream>
+#include <optional>
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+namespace net = boost::asio;
+
+struct NetLoop::Impl {
+    net::io_context ioc;
+    std::optional<net::executor_work_guard<net::io_context::executor_type>> work;
+};
+
+static std::atomic<int> g_sharedThreads{1};
+static std::atomic<bool> g_sharedBusyPoll{false};
+
+NetLoop::NetLoop(int threads, bool busyPoll)
+        : _impl(std::make_unique<Impl>()), _threads(std::max(threads, 1)), _busyPoll(busyPoll) {}
+
+NetLoop::~NetLoop() { stop(); }
+
+void NetLoop::start() {
+    if (_running.exchange(true)) return;
+    _impl->work.emplace(net::make_work_guard(_impl->ioc));
+    for (int i = 0; i < _threads; ++i) {
+        _workers.emplace_back([this]() {
+            // исключение из хендлера не должно убивать поток цикла
+            while (true) {
+                try {
+                    if (_busyPoll) {
+                        while (!_impl->ioc.stopped()) _impl->ioc.poll();
+                    } else {
+                        _impl->ioc.run();
+                    }
+                    break;
+                } catch (const std::exception &ex) {
+                    std::cerr << "[NetLoop] handler exception: " << ex.what() << std::endl;
+                }
+            }
+        });
+    }
+}
+
+void NetLoop::stop() {
+    if (!_running.exchange(false)) return;
+    _impl->work.reset();
+    _impl->ioc.stop();
+    for (auto &t : _workers) {
+        if (t.joinable()) t.join();
+    }
+    _workers.clear();
+}
+
+net::io_context &NetLoop::context() { return _impl->ioc; }
+
+bool NetLoop::runningInThisThread() const {
+    const auto self = std::this_thread::get_id();
+    return std::any_of(_workers.begin(), _workers.end(), [&](const std::thread &t) { return t.get_id() == self; });
+}
+
+void NetLoop::configureShared(int threads, bool busyPoll) {
+    g_sharedThreads.store(std::max(threads, 1));
+    g_sharedBusyPoll.store(busyPoll);
+}
+
+NetLoop &NetLoop::shared() {
+    static NetLoop loop(g_sharedThreads.load(), g_sharedBusyPoll.load());
+    loop.start();
+    return loop;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+namespace boost { namespace asio { class io_context; } }
+
+// Общий io_context для всех сокетов процесса: фиды и tx-сокет крутятся на N потоках,
+// каждая сессия сериализует свои read/write через strand.
+// busyPoll: потоки не засыпают в epoll, а крутят poll() — минус пробуждение на пути отправки ордера
+// ценой целого ядра на поток; только для выделенных ядер.
+class NetLoop {
+public:
+    explicit NetLoop(int threads = 1, bool busyPoll = false);
+    ~NetLoop();
+
+    void start();
+    void stop();
+
+    boost::asio::io_context &context();
+    // true, если вызывающий поток — один из потоков этого цикла
+    bool runningInThisThread() const;
+
+    // Процессный цикл; настройки применяются только до первого вызова shared()
+    static void configureShared(int threads, bool busyPoll = false);
+    static NetLoop &shared();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+    int _threads;
+    bool _busyPoll;
+    std::vector<std::thread> _workers;
+    std::atomic<bool> _running{false};
+};
@@ -0,0 +1,92 @@
+#include "OrderBookFrame.h"
+
+#include "FixedPoint.h"
+#include "JsonScan.h"
+
+void OrderBookFrame::clear() {
+    kind = Kind::Other;
+    hasOffset = false;
+    offset = 0;
+    channel = {};
+    bids.clear();
+    asks.clear();
+}
+
+// [{"price":"0.47937","size":"100.0"}, ...]
+static bool parseLevels(jsonscan::Cursor &c, long long priceScale, long long sizeScale, std::vector<PriceLevel> &out) {
+    return jsonscan::forEachElement(c, [&](jsonscan::Cursor &ec) {
+        std::string_view priceStr, sizeStr;
+        const bool ok = jsonscan::forEachMember(ec, [&](std::string_view key, jsonscan::Cursor &vc) {
+            if (key == "price") return jsonscan::readScalar(vc, priceStr);
+            if (key == "size") return jsonscan::readScalar(vc, sizeStr);
+            return jsonscan::skipValue(vc);
+        });
+        if (!ok) return false;
+        PriceLevel lvl;
+        // Запись с size <= 0 оставляем — апдейтер по ней удалит уровень
+        if (!priceStr.empty() && !sizeStr.empty() &&
+            fixedpoint::parseDecimal(priceStr, priceScale, lvl.price) &&
+            fixedpoint::parseDecimal(sizeStr, sizeScale, lvl.size) &&
+            lvl.price > 0) {
+            out.push_back(lvl);
+        }
+        return true;
+    });
+}
+
+bool parseOrderBookFrame(std::string_view json, long long priceScale, long long sizeScale, OrderBookFrame &out) {
+    out.clear();
+    bool hasBook = false;
+    bool bookHasOffset = false;
+    long long bookOffset = 0;
+    jsonscan::Cursor c(json);
+    const bool ok = jsonscan::forEachMember(c, [&](std::string_view key, jsonscan::Cursor &vc) {
+        if (key == "type") {
+            std::string_view type;
+            if (!jsonscan::readString(vc, type)) return false;
+            // первый кадр после подписки приходит как subscribed/order_book и несёт полную книгу
+            if (type == "snapshot/order_book" || type == "subscribed/order_book") out.kind = OrderBookFrame::Kind::Snapshot;
+            return true;
+        }
+        if (key == "offset") {
+            out.hasOffset = jsonscan::readInt(vc, out.offset);
+            return out.hasOffset;
+        }
+        if (key == "channel") return jsonscan::readString(vc, out.channel);
+        if (key == "order_book") {
+            hasBook = true;
+            return jsonscan::forEachMember(vc, [&](std::string_view bkey, jsonscan::Cursor &bc) {
+                if (bkey == "bids") return parseLevels(bc, priceScale, sizeScale, out.bids);
+                if (bkey == "asks") return parseLevels(bc, priceScale, sizeScale, out.asks);
+                if (bkey == "offset") {
+                    bookHasOffset = jsonscan::readInt(bc, bookOffset);
+                    return bookHasOffset;
+                }
+                return jsonscan::skipValue(bc);
+            });
+        }
+        return jsonscan::skipValue(vc);
+    });
+    if (!ok) return false;
+    // offset верхнего уровня приоритетнее вложенного
+    if (!out.hasOffset && bookHasOffset) {
+        out.hasOffset = true;
+        out.offset = bookOffset;
+    }
+    if (out.kind == OrderBookFrame::Kind::Other && hasBook) out.kind = OrderBookFrame::Kind::Update;
+    return true;
+}
+
+std::string_view peekChannel(std::string_view json) {
+    std::string_view channel;
+    bool found = false;
+    jsonscan::Cursor c(json);
+    jsonscan::forEachMember(c, [&](std::string_view key, jsonscan::Cursor &vc) {
+        if (key == "channel") {
+            found = jsonscan::readString(vc, channel);
+            return false; // дальше не читаем
+        }
+        return jsonscan::skipValue(vc);
+    });
+    return found ? channel : std::string_view{};
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "MarketDepth.h"
+
+// Разобранный кадр канала order_book/{N}. Векторы уровней переиспользуются между кадрами,
+// поэтому на горячем пути после прогрева аллокаций нет.
+struct OrderBookFrame {
+    enum class Kind { Other, Snapshot, Update };
+
+    Kind kind{Kind::Other};
+    bool hasOffset{false};
+    long long offset{0};
+    std::string_view channel; // срез исходного текста, валиден пока жив кадр
+    std::vector<PriceLevel> bids; // size <= 0 — удаление уровня
+    std::vector<PriceLevel> asks;
+
+    void clear();
+};
+
+// Один проход по тексту сообщения: тип, offset, канал и обе стороны сразу в тики/лоты.
+// false — если сообщение не JSON-объект.
+bool parseOrderBookFrame(std::string_view json, long long priceScale, long long sizeScale, OrderBookFrame &out);
+
+// Только поле "channel" верхнего уровня (у Lighter оно идёт первым, так что это почти бесплатно).
+// Нужен мультиплексору, чтобы выбрать скейлы рынка до полного разбора.
+std::string_view peekChannel(std::string_view json);
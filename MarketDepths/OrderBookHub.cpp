@@ -0,0 +1,123 @@
+#include "OrderBookHub.h"
+
+#include <algorithm>
+#include <iostream>
+
+OrderBookHub::OrderBookHub(Config cfg) : _cfg(std::move(cfg)) {
+    if (_cfg.connections < 1) _cfg.connections = 1;
+    const size_t nConn = std::min((size_t)_cfg.connections, std::max<size_t>(_cfg.markets.size(), 1));
+    for (size_t i = 0; i < nConn; ++i) _connections.push_back(std::make_unique<Connection>());
+
+    for (size_t i = 0; i < _cfg.markets.size(); ++i) {
+        auto m = std::make_unique<MarketState>();
+        m->cfg = _cfg.markets[i];
+        m->channel = "order_book/" + m->cfg.symbol;
+        m->connection = i % nConn;
+
+        OrderBookSync::Config sc;
+        sc.priceScale = m->cfg.priceScale;
+        sc.sizeScale = m->cfg.sizeScale;
+        sc.depthLimit = m->cfg.depthLimit;
+        sc.resyncTimeoutMs = _cfg.resyncTimeoutMs;
+        sc.maxBufferedDeltas = _cfg.maxBufferedDeltas;
+        sc.onDepthUpdated = m->cfg.onDepthUpdated;
+        MarketState *raw = m.get();
+        sc.requestResync = [this, raw]() { resubscribe(*raw); };
+        m->sync = std::make_unique<OrderBookSync>(std::move(sc));
+
+        _bySymbol[raw->cfg.symbol] = raw;
+        _markets.push_back(std::move(m));
+    }
+}
+
+OrderBookHub::~OrderBookHub() { stop(); }
+
+std::string OrderBookHub::subscribeText(const std::string &channel) {
+    return "{\"type\":\"subscribe\",\"channel\":\"" + channel + "\"}";
+}
+
+void OrderBookHub::start() {
+    if (_running.exchange(true)) return;
+    for (size_t c = 0; c < _connections.size(); ++c) {
+        WsSupervisor::Config scfg;
+        scfg.name = "OrderBookHub#" + std::to_string(c);
+        scfg.client.url = _cfg.url;
+        scfg.client.extraHeaders = _cfg.extraHeaders;
+        scfg.client.onMessage = [this, c](std::string_view data) { onMessage(c, data); };
+        // подписки уходят заново после каждого подключения, книги этого соединения ждут новые снапшоты
+        for (const auto &m : _markets) {
+            if (m->connection == c) scfg.subscribe.push_back(subscribeText(m->channel));
+        }
+        scfg.onReconnect = [this, c]() {
+            for (auto &m : _markets) {
+                if (m->connection == c) m->sync->reset();
+            }
+        };
+        // снапшот после переподписки мог потеряться, а дельт без него уже не будет — срок проверяет таймер
+        scfg.tickMs = std::max(100, _cfg.resyncTimeoutMs / 4);
+        scfg.onTick = [this, c]() {
+            for (auto &m : _markets) {
+                if (m->connection == c) m->sync->checkResync();
+            }
+        };
+        std::cout << "[OrderBookHub] connection " << c << ": " << scfg.subscribe.size() << " channels" << std::endl;
+        _connections[c]->ws = std::make_unique<WsSupervisor>(std::move(scfg));
+        _connections[c]->ws->start();
+    }
+}
+
+void OrderBookHub::stop() {
+    if (!_running.exchange(false)) return;
+    for (auto &c : _connections) {
+        if (c->ws) c->ws->stop();
+    }
+}
+
+OrderBookHub::MarketState *OrderBookHub::findByChannel(std::string_view channel) {
+    // "order_book:71" (в кадрах) или "order_book/71" — берём всё после разделителя
+    const size_t sep = channel.find_last_of(":/");
+    if (sep == std::string_view::npos) return nullptr;
+    auto it = _bySymbol.find(channel.substr(sep + 1));
+    return it == _bySymbol.end() ? nullptr : it->second;
+}
+
+const OrderBookHub::MarketState *OrderBookHub::findBySymbol(const std::string &symbol) const {
+    auto it = _bySymbol.find(symbol);
+    return it == _bySymbol.end() ? nullptr : it->second;
+}
+
+void OrderBookHub::onMessage(size_t connection, std::string_view jsonText) {
+    MarketState *m = findByChannel(peekChannel(jsonText));
+    if (!m || m->connection != connection) return; // служебные сообщения и чужие каналы
+    Connection &c = *_connections[connection];
+    if (!parseOrderBookFrame(jsonText, m->cfg.priceScale, m->cfg.sizeScale, c.frame)) return;
+    m->sync->onFrame(c.frame);
+}
+
+void OrderBookHub::resubscribe(const MarketState &m) {
+    WsSupervisor *ws = _connections[m.connection]->ws.get();
+    if (!ws) return;
+    std::cout << "[OrderBookHub] resubscribe " << m.channel << std::endl;
+    ws->sendText("{\"type\":\"unsubscribe\",\"channel\":\"" + m.channel + "\"}");
+    ws->sendText(subscribeText(m.channel));
+}
+
+const DepthSeqLock *OrderBookHub::published(const std::string &symbol) const {
+    const MarketState *m = findBySymbol(symbol);
+    return m ? &m->sync->published() : nullptr;
+}
+
+bool OrderBookHub::readDepth(const std::string &symbol, MarketDepth &out, long long *offset) const {
+    const DepthSeqLock *p = published(symbol);
+    return p && p->read(out, offset);
+}
+
+OrderBookSync::Stats OrderBookHub::syncStats(const std::string &symbol) const {
+    const MarketState *m = findBySymbol(symbol);
+    return m ? m->sync->stats() : OrderBookSync::Stats{};
+}
+
+WsSupervisor::Stats OrderBookHub::connectionStats(size_t connection) const {
+    if (connection >= _connections.size() || !_connections[connection]->ws) return WsSupervisor::Stats{};
+    return _connections[connection]->ws->stats();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+
+#include "MarketDepth.h"
+#include "OrderBookFrame.h"
+#include "OrderBookSync.h"
+#include "WsSupervisor.h"
+
+// Много каналов order_book/{N} поверх одного (или нескольких) WebSocket-соединений.
+// Кадры раскладываются по рынкам по полю channel, дальше у каждого рынка свой OrderBookSync.
+// Колбэки рынка вызываются из потока чтения его соединения.
+class OrderBookHub {
+public:
+    struct Market {
+        std::string symbol; // market_index
+        long long priceScale = 1;
+        long long sizeScale = 1;
+        int depthLimit = 50;
+        std::function<void(const MarketDepth&, long long)> onDepthUpdated;
+    };
+
+    struct Config {
+        std::string url;
+        std::vector<std::string> extraHeaders;
+        std::vector<Market> markets;
+        int connections = 1; // рынки раскладываются по соединениям по кругу
+        int resyncTimeoutMs = 2000;
+        size_t maxBufferedDeltas = 4096;
+    };
+
+    explicit OrderBookHub(Config cfg);
+    ~OrderBookHub();
+
+    void start();
+    void stop();
+
+    // nullptr — такого рынка нет
+    const DepthSeqLock *published(const std::string &symbol) const;
+    bool readDepth(const std::string &symbol, MarketDepth &out, long long *offset = nullptr) const;
+    OrderBookSync::Stats syncStats(const std::string &symbol) const;
+    WsSupervisor::Stats connectionStats(size_t connection) const;
+    size_t connectionCount() const { return _connections.size(); }
+
+private:
+    struct MarketState {
+        Market cfg;
+        std::string channel; // order_book/{symbol}
+        size_t connection{0};
+        std::unique_ptr<OrderBookSync> sync;
+    };
+    struct Connection {
+        std::unique_ptr<WsSupervisor> ws;
+        OrderBookFrame frame; // буферы разбора, у каждого потока чтения свои
+    };
+
+    void onMessage(size_t connection, std::string_view jsonText);
+    MarketState *findByChannel(std::string_view channel);
+    const MarketState *findBySymbol(const std::string &symbol) const;
+    void resubscribe(const MarketState &m);
+    static std::string subscribeText(const std::string &channel);
+
+    Config _cfg;
+    std::vector<std::unique_ptr<MarketState>> _markets;
+    std::unordered_map<std::string_view, MarketState*> _bySymbol; // ключи смотрят в _markets[i]->cfg.symbol
+    std::vector<std::unique_ptr<Connection>> _connections;
+    std::atomic<bool> _running{false};
+};
@@ -0,0 +1,146 @@
+#include "OrderBookSync.h"
+
+#include <algorithm>
+#include <iostream>
+
+OrderBookSync::OrderBookSync(Config cfg)
+        : _cfg(std::move(cfg)), _depth(_cfg.priceScale, _cfg.sizeScale),
+          _resyncRequestedAtNs(Clock::now().time_since_epoch().count()) {}
+
+OrderBookSync::Stats OrderBookSync::stats() const {
+    Stats s;
+    s.gaps = _gaps.load();
+    s.resyncRequests = _resyncRequests.load();
+    s.replayedDeltas = _replayedDeltas.load();
+    s.droppedDeltas = _droppedDeltas.load();
+    s.lastRecoveryUs = _lastRecoveryUs.load();
+    s.maxRecoveryUs = _maxRecoveryUs.load();
+    s.inSync = _inSync.load();
+    return s;
+}
+
+void OrderBookSync::reset() {
+    _hasSnapshot = false;
+    _lastOffset = -1;
+    _buffer.clear();
+    _resyncRequestedAtNs.store(Clock::now().time_since_epoch().count());
+    _inSync.store(false);
+}
+
+void OrderBookSync::publish() {
+    _published.publish(_depth, _lastOffset);
+    if (_cfg.onDepthUpdated) _cfg.onDepthUpdated(_depth, _lastOffset);
+}
+
+void OrderBookSync::onFrame(const OrderBookFrame &frame) {
+    const auto now = Clock::now();
+    if (frame.kind == OrderBookFrame::Kind::Snapshot) {
+        applySnapshot(frame, now);
+        return;
+    }
+    if (frame.kind != OrderBookFrame::Kind::Update) return;
+    if (!frame.hasOffset) return; // без offset безопаснее не применять
+
+    if (!_hasSnapshot) {
+        // Книги нет — копим дельты до снапшота, если он задерживается — просим ещё раз
+        bufferDelta(frame);
+        if (resyncDue(now)) requestResync(now);
+        return;
+    }
+    if (_lastOffset >= 0 && frame.offset <= _lastOffset) return; // старая/повторная дельта
+    if (_lastOffset >= 0 && frame.offset != _lastOffset + 1) {
+        std::cerr << "[OrderBookSync] offset gap: expected " << _lastOffset + 1 << " got " << frame.offset << std::endl;
+        onGap(now);
+        bufferDelta(frame);
+        return;
+    }
+    _lastOffset = frame.offset;
+
+    // Применяем инкрементальные изменения: size<=0 удаляет уровень, иначе обновляет/добавляет
+    _depth.update(frame.bids, frame.asks);
+    if (_cfg.depthLimit > 0) _depth.truncate((size_t)_cfg.depthLimit);
+    publish();
+}
+
+void OrderBookSync::applySnapshot(const OrderBookFrame &frame, Clock::time_point now) {
+    _depth.snapshot(frame.bids, frame.asks);
+    if (_cfg.depthLimit > 0) _depth.truncate((size_t)_cfg.depthLimit);
+    _hasSnapshot = true;
+    _lastOffset = frame.hasOffset ? frame.offset : -1;
+
+    // Накат накопленных дельт: всё, что не новее снапшота, выбрасываем, остальное — строго подряд
+    bool broken = false;
+    if (_lastOffset >= 0) {
+        std::stable_sort(_buffer.begin(), _buffer.end(), [](const BufferedDelta &l, const BufferedDelta &r) {
+            return l.offset < r.offset;
+        });
+        for (const auto &d : _buffer) {
+            if (d.offset <= _lastOffset) continue;
+            if (d.offset != _lastOffset + 1) { broken = true; break; }
+            _depth.update(d.bids, d.asks);
+            _lastOffset = d.offset;
+            _replayedDeltas.fetch_add(1);
+        }
+        if (_cfg.depthLimit > 0) _depth.truncate((size_t)_cfg.depthLimit);
+    }
+    _buffer.clear();
+    if (broken) {
+        // дыра внутри буфера — эта книга неполная, начинаем заново
+        onGap(now);
+        return;
+    }
+    _inSync.store(true);
+    if (_recovering) {
+        _recovering = false;
+        const long long us = std::chrono::duration_cast<std::chrono::microseconds>(now - _gapAt).count();
+        _lastRecoveryUs.store(us);
+        if (us > _maxRecoveryUs.load()) _maxRecoveryUs.store(us);
+        std::cout << "[OrderBookSync] resynced in " << us << " us" << std::endl;
+    }
+    publish();
+}
+
+void OrderBookSync::onGap(Clock::time_point now) {
+    _gaps.fetch_add(1);
+    _hasSnapshot = false;
+    _inSync.store(false);
+    if (!_recovering) {
+        _recovering = true;
+        _gapAt = now;
+    }
+    // Гасим книгу для читателей: лучше не котировать, чем котировать по дырявой
+    _depth.bids.clear();
+    _depth.asks.clear();
+    publish();
+    requestResync(now);
+}
+
+void OrderBookSync::bufferDelta(const OrderBookFrame &frame) {
+    if (_buffer.size() >= _cfg.maxBufferedDeltas) {
+        _buffer.erase(_buffer.begin());
+        _droppedDeltas.fetch_add(1);
+    }
+    _buffer.push_back(BufferedDelta{frame.offset, frame.bids, frame.asks});
+}
+
+void OrderBookSync::checkResync() {
+    const auto now = Clock::now();
+    if (resyncDue(now)) requestResync(now);
+}
+
+bool OrderBookSync::resyncDue(Clock::time_point now) {
+    if (_inSync.load()) return false;
+    const long long nowNs = now.time_since_epoch().count();
+    long long at = _resyncRequestedAtNs.load();
+    const long long timeoutNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::milliseconds(_cfg.resyncTimeoutMs)).count();
+    if (nowNs - at <= timeoutNs) return false;
+    // поток фида и таймер могут сойтись на одном сроке — переподписывается только один
+    return _resyncRequestedAtNs.compare_exchange_strong(at, nowNs);
+}
+
+void OrderBookSync::requestResync(Clock::time_point now) {
+    _resyncRequestedAtNs.store(now.time_since_epoch().count());
+    _resyncRequests.fetch_add(1);
+    if (_cfg.requestResync) _cfg.requestResync();
+}
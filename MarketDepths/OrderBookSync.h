@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "MarketDepth.h"
+#include "OrderBookFrame.h"
+#include "DepthSeqLock.h"
+
+// Синхронизация одной книги по кадрам order_book: снапшот + дельты по offset.
+// На разрыв offset книга гасится, запрашивается переподписка, а пришедшие дельты копятся
+// и накатываются поверх нового снапшота. Все методы, кроме stats()/published()/checkResync(), —
+// только из потока фида.
+class OrderBookSync {
+public:
+    struct Config {
+        long long priceScale = 1;
+        long long sizeScale = 1;
+        int depthLimit = 50;
+        int resyncTimeoutMs = 2000;      // нет снапшота дольше — переподписываемся ещё раз
+        size_t maxBufferedDeltas = 4096; // сверх этого старые дельты выбрасываются
+        std::function<void()> requestResync; // переподписка на канал (или иной способ получить снапшот)
+        std::function<void(const MarketDepth&, long long)> onDepthUpdated;
+    };
+
+    struct Stats {
+        uint64_t gaps{0};
+        uint64_t resyncRequests{0};
+        uint64_t replayedDeltas{0};
+        uint64_t droppedDeltas{0};
+        long long lastRecoveryUs{0}; // от обнаружения разрыва до валидной книги
+        long long maxRecoveryUs{0};
+        bool inSync{false};
+    };
+
+    explicit OrderBookSync(Config cfg);
+
+    void onFrame(const OrderBookFrame &frame);
+    // Снапшота нет дольше resyncTimeoutMs — переподписаться ещё раз. Из любого потока: владелец зовёт
+    // по таймеру, потому что после потерянного снапшота дельт (и вызовов onFrame) может не быть совсем
+    void checkResync();
+    // Соединение пересоздано: ждём снапшот от новой подписки, буфер старых дельт не нужен
+    void reset();
+
+    const DepthSeqLock &published() const { return _published; }
+    Stats stats() const;
+
+private:
+    struct BufferedDelta {
+        long long offset{0};
+        std::vector<PriceLevel> bids;
+        std::vector<PriceLevel> asks;
+    };
+    using Clock = std::chrono::steady_clock;
+
+    void applySnapshot(const OrderBookFrame &frame, Clock::time_point now);
+    void onGap(Clock::time_point now);
+    void bufferDelta(const OrderBookFrame &frame);
+    void requestResync(Clock::time_point now);
+    bool resyncDue(Clock::time_point now);
+    void publish();
+
+    Config _cfg;
+    MarketDepth _depth;          // рабочая книга
+    DepthSeqLock _published;     // то, что видят читатели
+    bool _hasSnapshot{false};
+    long long _lastOffset{-1};
+
+    std::vector<BufferedDelta> _buffer;
+    bool _recovering{false};
+    Clock::time_point _gapAt{};
+    std::atomic<long long> _resyncRequestedAtNs{0}; // steady_clock; пишут поток фида и таймер владельца
+
+    std::atomic<uint64_t> _gaps{0};
+    std::atomic<uint64_t> _resyncRequests{0};
+    std::atomic<uint64_t> _replayedDeltas{0};
+    std::atomic<uint64_t> _droppedDeltas{0};
+    std::atomic<long long> _lastRecoveryUs{0};
+    std::atomic<long long> _maxRecoveryUs{0};
+    std::atomic<bool> _inSync{false};
+};
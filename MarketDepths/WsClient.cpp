@@ -1,13 +1,20 @@
 #include "WsClient.h"
+#include "NetLoop.h"
+#include "MpscRing.h"
 
 #include <iostream>
 #include <chrono>
+#include <deque>
+#include <future>
+#include <vector>
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/ssl.hpp>
 #include <boost/asio/connect.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
 
 namespace beast = boost::beast;
 namespace websocket = beast::websocket;
@@ -33,134 +40,325 @@ static bool parseWssUrlWsClient(const std::string &url, std::string &host, std::
     return true;
 }
 
-WsClient::WsClient(Config cfg) : _cfg(std::move(cfg)) {}
-WsClient::~WsClient() { stop(); }
+static const std::string kPongText = "{\"type\":\"pong\"}";
 
-void WsClient::start() {
-    if (_running.exchange(true)) return;
-    _thr = std::thread([this]() { run(); });
+// Текстовый ping протокола приложения ("type":"ping" / "message_type":"ping") — кадр в пару десятков байт,
+// поэтому большие кадры стакана не сканируем вовсе, а маленькие — одним find
+static bool isAppPing(std::string_view data) {
+    constexpr size_t kMaxPingSize = 128;
+    return data.size() <= kMaxPingSize && data.find("type\":\"ping\"") != std::string_view::npos;
 }
 
-void WsClient::stop() {
-    if (!_running.exchange(false)) return;
-    if (_thr.joinable()) _thr.join();
-}
+using Strand = net::strand<net::io_context::executor_type>;
+
+// Исходящая очередь клиента. Кольцо пишут любые потоки, остальное — только на strand
+struct WsClient::Outbound {
+    MpscRing<std::string> ring;
+    Strand strand;
+    std::atomic<bool> drainPosted{false};   // сток уже в очереди strand'а — будить ещё раз не нужно
+    std::atomic<int> overflowPending{0};    // пока медленный путь не разобран, новые сообщения идут за ним
+    std::atomic<uint64_t> overflows{0};
+
+    std::deque<std::string> overflow;       // strand
+    std::weak_ptr<Session> session;         // strand: текущая сессия, которой отдаём сообщения
+
+    Outbound(size_t slots, size_t slotBytes, net::io_context &ioc) : ring(slots), strand(net::make_strand(ioc)) {
+        ring.forEachSlot([slotBytes](std::string &s) { s.reserve(slotBytes); });
+    }
+
+    void drain();
+};
+
+// Вся работа сессии — в хендлерах на её strand, поэтому поля ниже без мьютексов
+struct WsClient::Session : std::enable_shared_from_this<WsClient::Session> {
+    using Stream = websocket::stream<beast::ssl_stream<beast::tcp_stream>>;
 
-void WsClient::run() {
-    // база буста, всё взято из примеров доки
+    Config cfg;
+    std::shared_ptr<Outbound> out;
+    ssl::context sslCtx{ssl::context::tlsv12_client};
+    Strand strand;
+    tcp::resolver resolver;
+    net::steady_timer keepAlive;
+    std::unique_ptr<Stream> ws;
+    beast::flat_buffer buffer; // живёт всю сессию: после прогрева чтение не аллоцирует
+    std::deque<std::string> outbox;
+    std::vector<std::string> spare; // отправленные строки: их ёмкость возвращается в слоты кольца
     std::string host, port, target;
-    if (!parseWssUrlWsClient(_cfg.url, host, port, target)) return;
-
-    net::io_context ioc;
-    ssl::context ctx{ssl::context::tlsv12_client};
-    ctx.set_verify_mode(ssl::verify_none);
-
-    tcp::resolver resolver{ioc};
-    beast::ssl_stream<beast::tcp_stream> sslStream{ioc, ctx};
-    beast::error_code ec;
-
-    std::cout << "[WsClient] resolve " << host << ":" << port << " target=" << target << std::endl;
-    auto const results = resolver.resolve(host, port, ec);
-    if (ec) return;
-    beast::get_lowest_layer(sslStream).expires_after(std::chrono::seconds(10));
-    beast::get_lowest_layer(sslStream).connect(results, ec);
-    if (ec) {
-        std::cerr << "[WsClient] connect error: " << ec.message() << std::endl;
-        return;
+    std::chrono::steady_clock::time_point lastRead{};
+
+    bool open{false};
+    bool writing{false};
+    bool closing{false};
+    bool finished{false};
+    std::promise<void> done;
+    std::shared_future<void> doneFuture{done.get_future().share()};
+
+    Session(Config c, std::shared_ptr<Outbound> o)
+            : cfg(std::move(c)), out(std::move(o)), strand(out->strand), resolver(strand), keepAlive(strand) {
+        sslCtx.set_verify_mode(ssl::verify_none);
     }
-    if (ec) return;
 
-    if (!SSL_set_tlsext_host_name(sslStream.native_handle(), host.c_str())) {
-        return;
+    void start() {
+        net::dispatch(strand, [self = shared_from_this()]() {
+            self->out->session = self;
+            self->doResolve();
+        });
     }
-    beast::get_lowest_layer(sslStream).expires_after(std::chrono::seconds(10));
-    sslStream.handshake(ssl::stream_base::client, ec);
-    if (ec) {
-        std::cerr << "[WsClient] ssl handshake error: " << ec.message() << std::endl;
-        return;
+
+    // Всё накопившееся в кольце и на медленном пути — в outbox за один проход; до рукопожатия просто копим
+    void takeOutbound() {
+        while (out->ring.tryPop([this](std::string &slot) {
+            std::string msg;
+            if (!spare.empty()) {
+                msg = std::move(spare.back());
+                spare.pop_back();
+            }
+            msg.swap(slot);
+            outbox.push_back(std::move(msg));
+        })) {}
+        while (!out->overflow.empty()) {
+            outbox.push_back(std::move(out->overflow.front()));
+            out->overflow.pop_front();
+            out->overflowPending.fetch_sub(1);
+        }
+        if (open && !closing && !writing && !outbox.empty()) doWrite();
     }
 
-    websocket::stream<beast::ssl_stream<beast::tcp_stream>> ws{std::move(sslStream)};
-    ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
-    ws.text(true);
-    ws.set_option(websocket::stream_base::decorator([&](websocket::request_type &req){
-        req.set(beast::http::field::user_agent, std::string("MM-WSClient/1.0"));
-        for (const auto &h : _cfg.extraHeaders) {
-            auto p = h.find(':');
-            if (p == std::string::npos) continue;
-            std::string name = h.substr(0, p);
-            std::string value = h.substr(p + 1);
-            size_t i = 0; while (i < value.size() && (value[i] == ' ' || value[i] == '\t')) ++i;
-            value = value.substr(i);
-            if (name == "Authorization" || name == "authorization") {
-                req.set(beast::http::field::authorization, value);
+    void close() {
+        net::dispatch(strand, [self = shared_from_this()]() {
+            if (self->finished || self->closing) return;
+            self->closing = true;
+            self->keepAlive.cancel();
+            if (self->open) {
+                // close — тоже запись; если сейчас идёт write, закроемся из onWrite
+                if (!self->writing) self->doClose();
+            } else {
+                // ещё в процессе подключения: обрываем текущую операцию, её хендлер завершит сессию
+                self->resolver.cancel();
+                if (self->ws) beast::get_lowest_layer(*self->ws).close();
             }
+        });
+    }
+
+    void doResolve() {
+        if (closing) return finish();
+        if (!parseWssUrlWsClient(cfg.url, host, port, target)) {
+            std::cerr << "[WsClient] bad url: " << cfg.url << std::endl;
+            return finish();
         }
-    }));
+        ws = std::make_unique<Stream>(strand, sslCtx);
+        std::cout << "[WsClient] resolve " << host << ":" << port << " target=" << target << std::endl;
+        resolver.async_resolve(host, port, beast::bind_front_handler(&Session::onResolve, shared_from_this()));
+    }
 
-    std::string hostHeader = (port == "443" ? host : host + ":" + port);
-    ws.handshake(hostHeader, target, ec);
-    if (ec) {
-        std::cerr << "[WsClient] ws handshake error: " << ec.message() << std::endl;
-        return;
+    void onResolve(beast::error_code ec, tcp::resolver::results_type results) {
+        if (ec) return fail("resolve", ec);
+        if (closing) return finish();
+        beast::get_lowest_layer(*ws).expires_after(std::chrono::seconds(10));
+        beast::get_lowest_layer(*ws).async_connect(results, beast::bind_front_handler(&Session::onConnect, shared_from_this()));
     }
-    std::cout << "[WsClient] connected to wss://" << hostHeader << target << std::endl;
 
-    if (!_cfg.initialText.empty()) {
-        ws.write(net::buffer(_cfg.initialText), ec);
-        if (ec) return;
+    void onConnect(beast::error_code ec, tcp::resolver::results_type::endpoint_type) {
+        if (ec) return fail("connect", ec);
+        if (closing) return finish();
+        if (!SSL_set_tlsext_host_name(ws->next_layer().native_handle(), host.c_str())) {
+            std::cerr << "[WsClient] SNI setup failed" << std::endl;
+            return finish();
+        }
+        beast::get_lowest_layer(*ws).expires_after(std::chrono::seconds(10));
+        ws->next_layer().async_handshake(ssl::stream_base::client,
+                                         beast::bind_front_handler(&Session::onSslHandshake, shared_from_this()));
     }
 
-    // Цикл чтения, без активных задержек
-    while (_running.load()) {
-        beast::flat_buffer buffer;
-        beast::get_lowest_layer(ws).expires_after(std::chrono::seconds(5));
-        ws.read(buffer, ec);
-        if (ec) {
-            if (ec == net::error::operation_aborted) break;
-            if (ec == websocket::error::closed) {
-                try {
-                    auto cr = ws.reason();
-                    std::cerr << "[WsClient] closed by peer url=" << _cfg.url
-                              << " code=" << static_cast<int>(cr.code) << " reason=\"" << cr.reason << "\""
-                              << std::endl;
-                } catch (...) {
-                    std::cerr << "[WsClient] closed by peer url=" << _cfg.url << std::endl;
+    void onSslHandshake(beast::error_code ec) {
+        if (ec) return fail("ssl handshake", ec);
+        if (closing) return finish();
+        // дальше таймауты ведёт сам websocket: keep-alive ping'и и idle timeout
+        beast::get_lowest_layer(*ws).expires_never();
+        websocket::stream_base::timeout opt;
+        opt.handshake_timeout = std::chrono::seconds(10);
+        opt.idle_timeout = std::chrono::seconds(cfg.keepAliveSec * 2);
+        opt.keep_alive_pings = true;
+        ws->set_option(opt);
+        ws->text(true);
+        ws->set_option(websocket::stream_base::decorator([headers = cfg.extraHeaders](websocket::request_type &req){
+            req.set(beast::http::field::user_agent, std::string("MM-WSClient/1.0"));
+            for (const auto &h : headers) {
+                auto p = h.find(':');
+                if (p == std::string::npos) continue;
+                std::string name = h.substr(0, p);
+                std::string value = h.substr(p + 1);
+                size_t i = 0; while (i < value.size() && (value[i] == ' ' || value[i] == '\t')) ++i;
+                value = value.substr(i);
+                if (name == "Authorization" || name == "authorization") {
+                    req.set(beast::http::field::authorization, value);
                 }
-                break;
             }
-            if (ec == beast::error::timeout) {
-                // Таймаут тишины: отправим ping, чтобы держать соединение живым
-                beast::error_code pec;
-                ws.ping(websocket::ping_data{"ka"}, pec);
-                if (pec) {
-                    std::cerr << "[WsClient] ping error: " << pec.message() << std::endl;
-                }
-                // Некоторые серверы ожидают текстовый pong на уровне протокола JSON
-                beast::error_code wec;
-                static const std::string pongText = std::string("{\"type\":\"pong\"}");
-                ws.write(net::buffer(pongText), wec);
-                continue;
+        }));
+        const std::string hostHeader = (port == "443" ? host : host + ":" + port);
+        ws->async_handshake(hostHeader, target, beast::bind_front_handler(&Session::onHandshake, shared_from_this()));
+    }
+
+    void onHandshake(beast::error_code ec) {
+        if (ec) return fail("ws handshake", ec);
+        if (closing) return finish();
+        open = true;
+        lastRead = std::chrono::steady_clock::now();
+        std::cout << "[WsClient] connected to " << cfg.url << std::endl;
+        if (cfg.onOpen) cfg.onOpen();
+        if (!cfg.initialText.empty()) outbox.push_front(cfg.initialText);
+        takeOutbound();
+        armKeepAlive();
+        doRead();
+    }
+
+    void doRead() {
+        ws->async_read(buffer, beast::bind_front_handler(&Session::onRead, shared_from_this()));
+    }
+
+    void onRead(beast::error_code ec, std::size_t) {
+        if (ec) {
+            if (ec == websocket::error::closed && !closing) {
+                const auto &cr = ws->reason();
+                std::cerr << "[WsClient] closed by peer url=" << cfg.url
+                          << " code=" << static_cast<int>(cr.code) << " reason=\"" << cr.reason << "\"" << std::endl;
+                return finish();
             }
-            std::cerr << "[WsClient] read error: " << ec.message() << std::endl;
-            continue;
+            return fail("read", ec);
         }
-        std::string data = beast::buffers_to_string(buffer.data());
+        lastRead = std::chrono::steady_clock::now();
+        // flat_buffer непрерывен: отдаём подписчику срез прямо из него, без копии
+        const auto bytes = buffer.cdata();
+        const std::string_view data(static_cast<const char *>(bytes.data()), bytes.size());
         if (!data.empty()) {
-            // Ответ на текстовый ping по протоколу приложения: через внешнюю очередь (initialText уже прошёл)
-            if (data.find("\"type\":\"ping\"") != std::string::npos || data.find("\"message_type\":\"ping\"") != std::string::npos) {
-                // Для базового WsClient нет своей очереди записи, поэтому отправим немедленно
-                std::cout << data << std::endl;
-                static const std::string pongText = std::string("{\"type\":\"pong\"}");
-                beast::error_code wec;
-                ws.write(net::buffer(pongText), wec);
+            // Ответ на текстовый ping по протоколу приложения — через ту же очередь записи.
+            // Во время закрытия не пишем: async_write параллельно async_close Beast не допускает
+            if (open && !closing && isAppPing(data)) {
+                outbox.push_back(kPongText);
+                if (!writing) doWrite();
             }
-            if (_cfg.onMessage) _cfg.onMessage(data);
+            if (cfg.onMessage) {
+                try {
+                    cfg.onMessage(data);
+                } catch (const std::exception &ex) {
+                    std::cerr << "[WsClient] onMessage exception: " << ex.what() << std::endl;
+                }
+            }
+        }
+        // срез выше больше не нужен: память остаётся в буфере для следующего кадра
+        buffer.consume(buffer.size());
+        // и после async_close читаем дальше: close-кадр сервера придёт через read
+        doRead();
+    }
+
+    void doWrite() {
+        writing = true;
+        ws->async_write(net::buffer(outbox.front()), beast::bind_front_handler(&Session::onWrite, shared_from_this()));
+    }
+
+    void onWrite(beast::error_code ec, std::size_t) {
+        writing = false;
+        if (ec) {
+            // обрыв увидит и завершит чтение
+            std::cerr << "[WsClient] write error: " << ec.message() << std::endl;
+            return;
         }
+        if (spare.size() < out->ring.capacity()) spare.push_back(std::move(outbox.front()));
+        outbox.pop_front();
+        if (closing) return doClose();
+        if (!outbox.empty()) doWrite();
     }
-    beast::error_code _;
-    ws.close(websocket::close_code::normal, _);
-    std::cout << "[WsClient] closed url=" << _cfg.url << std::endl;
+
+    void doClose() {
+        open = false;
+        ws->async_close(websocket::close_code::normal, [self = shared_from_this()](beast::error_code) {
+            // завершение сессии придёт из onRead (closed / operation_aborted)
+            (void)self;
+        });
+    }
+
+    void armKeepAlive() {
+        keepAlive.expires_after(std::chrono::seconds(cfg.keepAliveSec));
+        keepAlive.async_wait([self = shared_from_this()](beast::error_code ec) {
+            if (ec || !self->open || self->closing) return;
+            // Некоторые серверы ожидают текстовый pong на уровне протокола JSON
+            if (std::chrono::steady_clock::now() - self->lastRead >= std::chrono::seconds(self->cfg.keepAliveSec)) {
+                self->outbox.push_back(kPongText);
+                if (!self->writing) self->doWrite();
+            }
+            self->armKeepAlive();
+        });
+    }
+
+    void fail(const char *what, beast::error_code ec) {
+        if (!closing) std::cerr << "[WsClient] " << what << " error: " << ec.message() << " url=" << cfg.url << std::endl;
+        finish();
+    }
+
+    void finish() {
+        if (finished) return;
+        finished = true;
+        open = false;
+        keepAlive.cancel();
+        if (out->session.lock().get() == this) out->session.reset();
+        if (ws) {
+            beast::error_code ignored;
+            beast::get_lowest_layer(*ws).socket().close(ignored);
+        }
+        std::cout << "[WsClient] closed url=" << cfg.url << std::endl;
+        if (cfg.onClosed) cfg.onClosed();
+        done.set_value();
+    }
+};
+
+void WsClient::Outbound::drain() {
+    // флаг снимаем до разбора: сообщение, положенное после этой точки, разбудит strand заново
+    drainPosted.store(false);
+    auto s = session.lock();
+    if (s && !s->finished) s->takeOutbound();
+    // нет живой сессии — сообщения ждут в кольце до рукопожатия следующей
+}
+
+WsClient::WsClient(Config cfg) : _cfg(std::move(cfg)) {
+    NetLoop &loop = _cfg.loop ? *_cfg.loop : NetLoop::shared();
+    _out = std::make_shared<Outbound>(_cfg.sendQueueSlots, _cfg.sendSlotBytes, loop.context());
+}
+WsClient::~WsClient() { stop(); }
+
+void WsClient::start() {
+    if (_running.exchange(true)) return;
+    std::lock_guard<std::mutex> lk(_mtx);
+    _session = std::make_shared<Session>(_cfg, _out);
+    _session->start();
 }
 
+void WsClient::stop() {
+    if (!_running.exchange(false)) return;
+    std::shared_ptr<Session> s;
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        s = std::move(_session);
+    }
+    if (!s) return;
+    s->close();
+    NetLoop &loop = _cfg.loop ? *_cfg.loop : NetLoop::shared();
+    if (!loop.runningInThisThread()) s->doneFuture.wait();
+}
+
+void WsClient::sendText(const std::string &text) {
+    Outbound &q = *_out;
+    if (q.overflowPending.load() == 0 && q.ring.tryPush([&text](std::string &slot) { slot.assign(text); })) {
+        // один post на пачку: пока сток не отработал, следующие сообщения только ложатся в кольцо
+        if (!q.drainPosted.exchange(true)) net::post(q.strand, [out = _out]() { out->drain(); });
+        return;
+    }
+    // кольцо полно — через strand с копией; сохраняет порядок, пока не разобрано
+    q.overflows.fetch_add(1);
+    q.overflowPending.fetch_add(1);
+    net::post(q.strand, [out = _out, msg = text]() mutable {
+        out->overflow.push_back(std::move(msg));
+        out->drain();
+    });
+}
 
+uint64_t WsClient::sendOverflows() const { return _out->overflows.load(); }
@@ -1,30 +1,56 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <functional>
-#include <thread>
+#include <memory>
 #include <atomic>
-#include <vector>
+#include <mutex>
+#include <cstdint>
 
+class NetLoop;
+
+// Асинхронная WebSocket-сессия (wss) на общем NetLoop. Чтение и запись сериализуются strand'ом сессии,
+// поэтому sendText можно звать из любого потока, в том числе параллельно с приёмом.
+// Исходящие сообщения идут через lock-free кольцо с заранее выделенными слотами: отправитель кладёт
+// кадр и будит strand одним post на пачку, strand забирает из кольца всё накопившееся за проход.
 class WsClient {
 public:
     struct Config {
         std::string url;                       // wss://host[:port]/path
         std::vector<std::string> extraHeaders;
-        std::function<void(const std::string&)> onMessage; // callback для текстовых сообщений
+        // Текстовые сообщения. Срез указывает в буфер приёма и валиден только на время вызова:
+        // чтобы сохранить данные, подписчик копирует их сам (std::string(data))
+        std::function<void(std::string_view)> onMessage;
         std::string initialText;
+        // из потока цикла: соединение установлено / сессия завершилась (ошибкой, закрытием или stop())
+        std::function<void()> onOpen;
+        std::function<void()> onClosed;
+        NetLoop *loop = nullptr;   // nullptr — NetLoop::shared()
+        int keepAliveSec = 5;      // столько тишины — шлём текстовый pong, вдвое больше — сессия считается мёртвой
+        size_t sendQueueSlots = 64;   // ёмкость кольца исходящих (до степени двойки); при переполнении — медленный путь
+        size_t sendSlotBytes = 256;   // ёмкость строки в каждом слоте, резервируется заранее
     };
 
     explicit WsClient(Config cfg);
     ~WsClient();
 
     void start();
+    // Закрывает сессию и ждёт её завершения (кроме вызова из потока цикла — тогда без ожидания)
     void stop();
+
+    // Потокобезопасно и без блокировок; до start() сообщения копятся и уходят сразу после рукопожатия
+    void sendText(const std::string &text);
+
+    // Сколько сообщений не поместилось в кольцо и ушло медленным путём (с аллокацией)
+    uint64_t sendOverflows() const;
 private:
-    void run();
+    struct Session;
+    struct Outbound;
 
     Config _cfg;
-    std::thread _thr;
     std::atomic<bool> _running{false};
-};
-
+    std::shared_ptr<Outbound> _out; // кольцо и strand живут дольше отдельной сессии
 
+    std::mutex _mtx; // start/stop
+    std::shared_ptr<Session> _session;
+};
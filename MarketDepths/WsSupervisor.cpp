@@ -0,0 +1,188 @@
+#include "WsSupervisor.h"
+#include "NetLoop.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+namespace net = boost::asio;
+
+static long long nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct WsSupervisor::Impl : std::enable_shared_from_this<WsSupervisor::Impl> {
+    Config cfg;
+    NetLoop &loop;
+    net::steady_timer timer;
+    net::steady_timer tickTimer;
+    std::mutex tickMtx; // держится на время onTick: stop() по нему дожидается идущего вызова
+    std::mt19937 rng{std::random_device{}()};
+
+    std::mutex mtx; // running/backoff/sessionStart; ws меняется под ним, а читается без него
+    bool running{false};
+    // текущая сессия: sendText берёт её без mtx — отправка не ждёт подключения и onReconnect
+    std::atomic<std::shared_ptr<WsClient>> ws;
+    int backoffMs{0};
+    std::chrono::steady_clock::time_point sessionStart{};
+
+    std::atomic<uint64_t> sessions{0};
+    std::atomic<uint64_t> reconnects{0};
+    std::atomic<bool> connected{false};
+    std::atomic<long long> downSinceUs{0}; // 0 — соединение живо или ещё не падало
+    std::atomic<long long> lastDowntimeUs{0};
+    std::atomic<long long> totalDowntimeUs{0};
+
+    explicit Impl(Config c)
+            : cfg(std::move(c)), loop(cfg.client.loop ? *cfg.client.loop : NetLoop::shared()),
+              timer(loop.context()), tickTimer(loop.context()), backoffMs(cfg.backoffInitialMs) {}
+
+    // под mtx
+    void armTickLocked() {
+        if (cfg.tickMs <= 0 || !cfg.onTick) return;
+        tickTimer.expires_after(std::chrono::milliseconds(cfg.tickMs));
+        tickTimer.async_wait([self = shared_from_this()](const boost::system::error_code &ec) {
+            if (!ec) self->onTickTimer();
+        });
+    }
+
+    void onTickTimer() {
+        {
+            std::lock_guard<std::mutex> tk(tickMtx);
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                if (!running) return;
+            }
+            // между сессиями владельцу делать нечего: переподключение само вернёт подписки
+            if (connected.load()) cfg.onTick();
+        }
+        std::lock_guard<std::mutex> lk(mtx);
+        if (running) armTickLocked();
+    }
+
+    void markDown() {
+        if (connected.exchange(false)) downSinceUs.store(nowUs());
+    }
+
+    // под mtx
+    void connectLocked() {
+        if (sessions.load() > 0) {
+            reconnects.fetch_add(1);
+            if (cfg.onReconnect) cfg.onReconnect();
+        }
+        std::weak_ptr<Impl> weak = shared_from_this();
+        WsClient::Config wcfg = cfg.client;
+        wcfg.onOpen = [weak]() {
+            auto self = weak.lock();
+            if (!self) return;
+            const long long since = self->downSinceUs.exchange(0);
+            if (since > 0) {
+                const long long down = nowUs() - since;
+                self->lastDowntimeUs.store(down);
+                self->totalDowntimeUs.fetch_add(down);
+            }
+            self->connected.store(true);
+        };
+        wcfg.onClosed = [weak]() {
+            auto self = weak.lock();
+            if (!self) return;
+            self->markDown();
+            // WsClient не разрушаем из его же колбэка — дальше из отдельного хендлера
+            net::post(self->loop.context(), [self]() { self->onSessionClosed(); });
+        };
+        auto client = std::make_shared<WsClient>(wcfg);
+        // подписки — раньше всего, что отправят через sendText после публикации сессии
+        for (const auto &msg : cfg.subscribe) client->sendText(msg);
+        ws.store(client);
+        sessions.fetch_add(1);
+        sessionStart = std::chrono::steady_clock::now();
+        client->start();
+    }
+
+    void onSessionClosed() {
+        std::shared_ptr<WsClient> finished;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (!running) return;
+            finished = ws.exchange(nullptr);
+            if (std::chrono::steady_clock::now() - sessionStart > std::chrono::milliseconds(cfg.stableAfterMs)) {
+                backoffMs = cfg.backoffInitialMs;
+            }
+            std::uniform_real_distribution<double> jitter(1.0 - cfg.jitter, 1.0 + cfg.jitter);
+            const int delayMs = (int)(backoffMs * jitter(rng));
+            backoffMs = std::min(backoffMs * 2, cfg.backoffMaxMs);
+            std::cerr << "[WsSupervisor] " << cfg.name << " disconnected, reconnect in " << delayMs << " ms" << std::endl;
+            timer.expires_after(std::chrono::milliseconds(delayMs));
+            timer.async_wait([self = shared_from_this()](const boost::system::error_code &ec) {
+                if (ec) return;
+                std::lock_guard<std::mutex> lk(self->mtx);
+                if (self->running) self->connectLocked();
+            });
+        }
+        // сессия уже завершена, stop() не ждёт
+    }
+};
+
+WsSupervisor::WsSupervisor(Config cfg) : _impl(std::make_shared<Impl>(std::move(cfg))) {}
+WsSupervisor::~WsSupervisor() { stop(); }
+
+void WsSupervisor::start() {
+    std::lock_guard<std::mutex> lk(_impl->mtx);
+    if (_impl->running) return;
+    _impl->running = true;
+    _impl->connectLocked();
+    _impl->armTickLocked();
+}
+
+void WsSupervisor::stop() {
+    std::shared_ptr<WsClient> current;
+    {
+        std::lock_guard<std::mutex> lk(_impl->mtx);
+        if (!_impl->running) return;
+        _impl->running = false;
+        _impl->timer.cancel();
+        _impl->tickTimer.cancel();
+        current = _impl->ws.exchange(nullptr);
+    }
+    // onTick, начатый до остановки, должен закончиться: после stop() владелец может разрушаться
+    { std::lock_guard<std::mutex> tk(_impl->tickMtx); }
+    // вне mtx: колбэки сессии сами берут его в onSessionClosed
+    if (current) current->stop();
+    _impl->markDown();
+    _impl->downSinceUs.store(0);
+}
+
+void WsSupervisor::sendText(const std::string &text) {
+    // копия указателя держит сессию, даже если её тут же сменят: кадр уйдёт в закрытую и потеряется,
+    // как и любой кадр между сессиями
+    if (auto ws = _impl->ws.load()) ws->sendText(text);
+}
+
+void WsSupervisor::reconnect(const std::string &reason) {
+    std::cerr << "[WsSupervisor] " << _impl->cfg.name << " forced reconnect: " << reason << std::endl;
+    // на NetLoop: там закрытие сессии не ждёт её завершения, а onClosed запустит переподключение
+    net::post(_impl->loop.context(), [self = _impl]() {
+        std::lock_guard<std::mutex> lk(self->mtx);
+        if (!self->running) return;
+        if (auto ws = self->ws.load()) ws->stop();
+    });
+}
+
+WsSupervisor::Stats WsSupervisor::stats() const {
+    Stats s;
+    s.sessions = _impl->sessions.load();
+    s.reconnects = _impl->reconnects.load();
+    s.connected = _impl->connected.load();
+    s.lastDowntimeUs = _impl->lastDowntimeUs.load();
+    s.totalDowntimeUs = _impl->totalDowntimeUs.load();
+    const long long since = _impl->downSinceUs.load();
+    if (since > 0) s.totalDowntimeUs += nowUs() - since; // текущий простой тоже считаем
+    return s;
+}
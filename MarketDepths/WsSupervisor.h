@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+#include "WsClient.h"
+
+// Владелец жизненного цикла WsClient: без своего потока, переподключение по таймеру на NetLoop
+// с экспоненциальной задержкой и джиттером; подписки уходят заново после каждого подключения.
+class WsSupervisor {
+public:
+    struct Config {
+        std::string name;                    // для логов
+        WsClient::Config client;             // onOpen/onClosed перехватываются супервизором
+        std::vector<std::string> subscribe;  // уходят после каждого подключения, вслед за client.initialText
+        int backoffInitialMs = 200;
+        int backoffMaxMs = 10000;
+        double jitter = 0.2;                 // +-20% к задержке
+        int stableAfterMs = 10000;           // сессия прожила дольше — задержка сбрасывается
+        // перед каждой новой сессией (старая уже завершена) — например, сбросить книгу
+        std::function<void()> onReconnect;
+        // >0 — onTick раз в tickMs на NetLoop, пока сессия подключена: таймауты владельца без своего потока.
+        // После stop() не зовётся и не выполняется
+        int tickMs = 0;
+        std::function<void()> onTick;
+    };
+
+    struct Stats {
+        uint64_t sessions{0};      // запущенных сессий
+        uint64_t reconnects{0};    // из них после обрыва
+        bool connected{false};
+        long long lastDowntimeUs{0};
+        long long totalDowntimeUs{0};
+    };
+
+    explicit WsSupervisor(Config cfg);
+    ~WsSupervisor();
+
+    void start();
+    void stop();
+
+    // В текущую сессию, без локов супервизора; между сессиями сообщение теряется (подписки вернёт переподключение)
+    void sendText(const std::string &text);
+    // Закрыть текущую сессию и переподключиться обычным путём (задержка, подписки, onReconnect) —
+    // когда состояние канала уже не восстановить. Любой поток, не ждёт
+    void reconnect(const std::string &reason);
+
+    Stats stats() const;
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> _impl; // живёт, пока на него смотрят хендлеры таймера и сессии
+};
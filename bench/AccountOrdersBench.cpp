@@ -0,0 +1,66 @@
+// Разбор account_all_orders: прежний парсер (find на каждое поле) против однопроходного.
+// Сборка: cmake -DMM_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release; запуск: ./bench-account-orders [каталог кадров]
+#include <cstdio>
+
+#include "AccountOrdersFrame.h"
+#include "BenchUtil.h"
+#include "legacy/LegacyParsers.h"
+
+static constexpr long long kPriceScale = 100000;
+static constexpr long long kSizeScale = 10;
+
+static bool sameOrder(const AccountAllOrdersWS::Order &a, const AccountAllOrdersWS::Order &b) {
+    return a.order_index == b.order_index && a.client_order_index == b.client_order_index &&
+           a.price == b.price && a.initial_base_amount == b.initial_base_amount &&
+           a.remaining_base_amount == b.remaining_base_amount && a.filled_base_amount == b.filled_base_amount &&
+           a.timestamp == b.timestamp && a.market_index == b.market_index && a.side == b.side &&
+           a.status == b.status && a.type == b.type && a.time_in_force == b.time_in_force;
+}
+
+int main(int argc, char **argv) {
+    const std::vector<std::string> frames = bench::loadFrames(bench::fixturePath(argc, argv, "account_all_orders.jsonl"));
+    if (frames.empty()) return 1;
+
+    std::vector<AccountAllOrdersWS::Order> oldOrders;
+    std::vector<AccountAllOrdersWS::OrderDetails> oldDetails;
+    AccountOrdersFrame frame;
+
+    std::printf("%5s %9s %7s %12s %12s %8s\n", "frame", "bytes", "orders", "old ns", "new ns", "speedup");
+    double oldTotal = 0, newTotal = 0;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const std::string &f = frames[i];
+
+        // Оба парсера обязаны дать одно и то же — иначе сравнивать скорость нет смысла
+        oldOrders.clear();
+        oldDetails.clear();
+        legacy::parseAccountOrders(f, kPriceScale, kSizeScale, oldOrders, oldDetails);
+        if (!parseAccountOrdersFrame(f, kPriceScale, kSizeScale, frame) || frame.orders.size() != oldOrders.size()) {
+            std::fprintf(stderr, "frame %zu: parsers disagree on order count\n", i);
+            return 1;
+        }
+        for (size_t k = 0; k < oldOrders.size(); ++k) {
+            if (!sameOrder(oldOrders[k], frame.orders[k]) || oldDetails[k].order_id != frame.details[k].order_id ||
+                oldDetails[k].nonce != frame.details[k].nonce) {
+                std::fprintf(stderr, "frame %zu: parsers disagree on order %zu\n", i, k);
+                return 1;
+            }
+        }
+
+        const int iters = bench::itersFor(f.size());
+        const double oldNs = bench::nsPerCall(iters, [&] {
+            oldOrders.clear();
+            oldDetails.clear();
+            legacy::parseAccountOrders(f, kPriceScale, kSizeScale, oldOrders, oldDetails);
+            bench::keep((long long) oldOrders.size());
+        });
+        const double newNs = bench::nsPerCall(iters, [&] {
+            parseAccountOrdersFrame(f, kPriceScale, kSizeScale, frame);
+            bench::keep((long long) frame.orders.size());
+        });
+        oldTotal += oldNs;
+        newTotal += newNs;
+        std::printf("%5zu %9zu %7zu %12.0f %12.0f %7.1fx\n", i, f.size(), frame.orders.size(), oldNs, newNs, oldNs / newNs);
+    }
+    std::printf("total %36.0f %12.0f %7.1fx\n", oldTotal, newTotal, oldTotal / newTotal);
+    return 0;
+}
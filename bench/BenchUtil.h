@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Общее для бенчмарков парсеров: кадры из файла (один JSON на строку) и замер ns на вызов.
+namespace bench {
+
+// Каталог с записанными кадрами: первый аргумент командной строки или bench/fixtures из CMake
+inline std::string fixturePath(int argc, char **argv, const char *file) {
+    if (argc > 1) return std::string(argv[1]) + "/" + file;
+    return std::string(BENCH_FIXTURES_DIR) + "/" + file;
+}
+
+inline std::vector<std::string> loadFrames(const std::string &path) {
+    std::vector<std::string> frames;
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "[bench] cannot open " << path << std::endl;
+        return frames;
+    }
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty()) frames.push_back(std::move(line));
+    }
+    return frames;
+}
+
+// Итераций столько, чтобы на кадр ушло порядка десятков миллисекунд на самом медленном парсере
+inline int itersFor(size_t bytes) {
+    return (int) std::clamp<size_t>(20'000'000 / std::max<size_t>(bytes, 1), 20, 20000);
+}
+
+// Медиана из нескольких прогонов: один прогон легко портит планировщик
+template <typename F>
+double nsPerCall(int iters, F &&fn) {
+    for (int i = 0; i < std::max(1, iters / 10); ++i) fn(); // прогрев: кэши, ёмкость векторов
+    double runs[5];
+    for (double &r : runs) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; ++i) fn();
+        r = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / iters;
+    }
+    std::sort(std::begin(runs), std::end(runs));
+    return runs[2];
+}
+
+// Не даём компилятору выкинуть результат разбора
+inline void keep(long long v) {
+    static volatile long long sink = 0;
+    sink = sink + v;
+}
+
+} // namespace bench
@@ -0,0 +1,58 @@
+// Разбор order_book: прежний парсер (копия объекта на сторону, find + strtod) против однопроходного.
+// Сборка: cmake -DMM_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release; запуск: ./bench-order-book [каталог кадров]
+#include <cmath>
+#include <cstdio>
+
+#include "BenchUtil.h"
+#include "OrderBookFrame.h"
+#include "legacy/LegacyParsers.h"
+
+static constexpr long long kPriceScale = 100000;
+static constexpr long long kSizeScale = 10;
+
+// Прежний парсер отдаёт float, текущий — тики/лоты: сверяем после масштабирования
+static bool sameLevels(const std::vector<std::pair<float, float>> &old, const std::vector<PriceLevel> &cur) {
+    if (old.size() != cur.size()) return false;
+    for (size_t i = 0; i < old.size(); ++i) {
+        if (std::llround((double) old[i].first * kPriceScale) != cur[i].price) return false;
+        if (std::llround((double) old[i].second * kSizeScale) != cur[i].size) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const std::vector<std::string> frames = bench::loadFrames(bench::fixturePath(argc, argv, "order_book.jsonl"));
+    if (frames.empty()) return 1;
+
+    legacy::OrderBookFrame oldFrame;
+    OrderBookFrame frame;
+
+    std::printf("%5s %7s %7s %10s %10s %8s\n", "frame", "bytes", "levels", "old ns", "new ns", "speedup");
+    double oldTotal = 0, newTotal = 0;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const std::string &f = frames[i];
+
+        legacy::parseOrderBook(f, oldFrame);
+        if (!parseOrderBookFrame(f, kPriceScale, kSizeScale, frame) || oldFrame.offset.value_or(-1) != frame.offset ||
+            !sameLevels(oldFrame.bids, frame.bids) || !sameLevels(oldFrame.asks, frame.asks)) {
+            std::fprintf(stderr, "frame %zu: parsers disagree\n", i);
+            return 1;
+        }
+
+        const int iters = bench::itersFor(f.size());
+        const double oldNs = bench::nsPerCall(iters, [&] {
+            legacy::parseOrderBook(f, oldFrame);
+            bench::keep((long long) (oldFrame.bids.size() + oldFrame.asks.size()));
+        });
+        const double newNs = bench::nsPerCall(iters, [&] {
+            parseOrderBookFrame(f, kPriceScale, kSizeScale, frame);
+            bench::keep((long long) (frame.bids.size() + frame.asks.size()));
+        });
+        oldTotal += oldNs;
+        newTotal += newNs;
+        std::printf("%5zu %7zu %7zu %10.0f %10.0f %7.1fx\n", i, f.size(), frame.bids.size() + frame.asks.size(),
+                    oldNs, newNs, oldNs / newNs);
+    }
+    std::printf("mean %28.0f %10.0f %7.1fx\n", oldTotal / frames.size(), newTotal / frames.size(), oldTotal / newTotal);
+    return 0;
+}
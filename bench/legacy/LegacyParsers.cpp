@@ -0,0 +1,273 @@
+#include "LegacyParsers.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "FixedPoint.h"
+
+namespace legacy {
+
+using Order = AccountAllOrdersWS::Order;
+using OrderDetails = AccountAllOrdersWS::OrderDetails;
+using Side = AccountAllOrdersWS::Side;
+
+static std::string extractBlock(std::string_view src, const std::string &key, char open, char close) {
+    std::string marker = '"' + key + '"';
+    size_t p = src.find(marker);
+    if (p == std::string_view::npos) return {};
+    p = src.find(open, p);
+    if (p == std::string_view::npos) return {};
+    int d = 0;
+    for (size_t i = p; i < src.size(); ++i) {
+        if (src[i] == open) d++;
+        else if (src[i] == close) { d--; if (d == 0) return std::string(src.substr(p, i - p + 1)); }
+    }
+    return {};
+}
+
+// Строковые поля биржи -> enum; неизвестное — Unknown, ордер всё равно учитывается
+static AccountAllOrdersWS::Status parseStatus(std::string_view s) {
+    using S = AccountAllOrdersWS::Status;
+    if (s == "open") return S::Open;
+    if (s == "filled") return S::Filled;
+    if (s == "pending") return S::Pending;
+    if (s == "in-progress") return S::InProgress;
+    // canceled, canceled-post-only, canceled-expired, ... — причина остаётся в OrderDetails::status
+    if (s.rfind("canceled", 0) == 0 || s == "expired") return S::Canceled;
+    return S::Unknown;
+}
+
+static AccountAllOrdersWS::Type parseType(std::string_view s) {
+    using T = AccountAllOrdersWS::Type;
+    if (s == "limit") return T::Limit;
+    if (s == "market") return T::Market;
+    if (s == "stop-loss") return T::StopLoss;
+    if (s == "stop-loss-limit") return T::StopLossLimit;
+    if (s == "take-profit") return T::TakeProfit;
+    if (s == "take-profit-limit") return T::TakeProfitLimit;
+    if (s == "twap") return T::Twap;
+    if (s == "twap-sub") return T::TwapSub;
+    if (s == "liquidation") return T::Liquidation;
+    return T::Unknown;
+}
+
+static AccountAllOrdersWS::TimeInForce parseTimeInForce(std::string_view s) {
+    using F = AccountAllOrdersWS::TimeInForce;
+    if (s == "good-till-time") return F::GoodTillTime;
+    if (s == "immediate-or-cancel") return F::ImmediateOrCancel;
+    if (s == "post-only") return F::PostOnly;
+    return F::Unknown;
+}
+
+bool parseAccountOrders(std::string_view json, long long priceScale, long long sizeScale,
+                        std::vector<Order> &changed, std::vector<OrderDetails> &details) {
+    const bool snapshot = json.find("\"type\":\"subscribed/account_all_orders\"") != std::string_view::npos;
+    if (!snapshot && json.find("\"type\":\"update/account_all_orders\"") == std::string_view::npos) return false;
+    std::string ordersObj = extractBlock(json, "orders", '{', '}');
+    size_t cur = 0;
+    while (true) {
+        size_t keyQ1 = ordersObj.find('"', cur);
+        if (keyQ1 == std::string::npos) break;
+        size_t keyQ2 = ordersObj.find('"', keyQ1 + 1);
+        if (keyQ2 == std::string::npos) break;
+        size_t arrStart = ordersObj.find('[', keyQ2);
+        if (arrStart == std::string::npos) break;
+        int d = 0; size_t arrEnd = std::string::npos;
+        for (size_t i = arrStart; i < ordersObj.size(); ++i) {
+            if (ordersObj[i] == '[') d++;
+            else if (ordersObj[i] == ']') { d--; if (d == 0) { arrEnd = i; break; } }
+        }
+        if (arrEnd == std::string::npos) break;
+        std::string arr = ordersObj.substr(arrStart, arrEnd - arrStart + 1);
+        size_t p = 0;
+        while (true) {
+            size_t oStart = arr.find('{', p);
+            if (oStart == std::string::npos) break;
+            int dd = 0; size_t oEnd = std::string::npos;
+            for (size_t i = oStart; i < arr.size(); ++i) {
+                if (arr[i] == '{') dd++; else if (arr[i] == '}') { dd--; if (dd == 0) { oEnd = i; break; } }
+            }
+            if (oEnd == std::string::npos) break;
+            std::string o = arr.substr(oStart, oEnd - oStart + 1);
+
+            auto getString = [&](const char* key)->std::string_view{
+                std::string mk = std::string("\"") + key + "\"";
+                size_t p = o.find(mk); if (p == std::string::npos) return {};
+                p = o.find(':', p); if (p == std::string::npos) return {};
+                size_t q1 = o.find('"', p); if (q1 == std::string::npos) return {};
+                size_t q2 = o.find('"', q1 + 1); if (q2 == std::string::npos) return {};
+                return std::string_view(o).substr(q1 + 1, q2 - q1 - 1);
+            };
+            auto getInt = [&](const char* key)->long long{
+                std::string mk = std::string("\"") + key + "\"";
+                size_t p = o.find(mk); if (p == std::string::npos) return 0;
+                p = o.find(':', p); if (p == std::string::npos) return 0;
+                ++p; while (p < o.size() && (o[p]==' '||o[p]=='\t')) ++p;
+                return std::strtoll(o.c_str()+p, nullptr, 10);
+            };
+            auto getBool = [&](const char* key)->bool{
+                std::string mk = std::string("\"") + key + "\"";
+                size_t p = o.find(mk); if (p == std::string::npos) return false;
+                p = o.find(':', p); if (p == std::string::npos) return false;
+                ++p; while (p < o.size() && (o[p]==' '||o[p]=='\t')) ++p;
+                return o.compare(p, 4, "true") == 0;
+            };
+            auto getFixed = [&](const char* key, long long scale)->long long{
+                long long v = 0;
+                fixedpoint::parseDecimal(getString(key), scale, v);
+                return v;
+            };
+
+            Order ord;
+            ord.order_index = getInt("order_index");
+            ord.client_order_index = getInt("client_order_index");
+            ord.market_index = (int)getInt("market_index");
+            ord.price = getFixed("price", priceScale);
+            ord.initial_base_amount = getFixed("initial_base_amount", sizeScale);
+            ord.remaining_base_amount = getFixed("remaining_base_amount", sizeScale);
+            ord.filled_base_amount = getFixed("filled_base_amount", sizeScale);
+            ord.side = getBool("is_ask") ? Side::Sell : Side::Buy;
+            ord.type = parseType(getString("type"));
+            ord.time_in_force = parseTimeInForce(getString("time_in_force"));
+            const std::string_view status = getString("status");
+            ord.status = parseStatus(status);
+            ord.timestamp = getInt("timestamp");
+
+            OrderDetails det;
+            det.order_id = getString("order_id");
+            det.client_order_id = getString("client_order_id");
+            det.status = status;
+            det.filled_quote_amount = getString("filled_quote_amount");
+            det.trigger_status = getString("trigger_status");
+            det.parent_order_id = getString("parent_order_id");
+            det.to_trigger_order_id_0 = getString("to_trigger_order_id_0");
+            det.to_trigger_order_id_1 = getString("to_trigger_order_id_1");
+            det.to_cancel_order_id_0 = getString("to_cancel_order_id_0");
+            det.trigger_price = getFixed("trigger_price", priceScale);
+            det.nonce = getInt("nonce");
+            det.order_expiry = getInt("order_expiry");
+            det.trigger_time = getInt("trigger_time");
+            det.parent_order_index = getInt("parent_order_index");
+            det.block_height = getInt("block_height");
+            det.owner_account_index = (int)getInt("owner_account_index");
+            det.base_size = (int)getInt("base_size");
+            det.base_price = (int)getInt("base_price");
+            det.reduce_only = getBool("reduce_only");
+
+            details.push_back(std::move(det));
+            changed.push_back(std::move(ord));
+            p = oEnd + 1;
+        }
+        cur = arrEnd + 1;
+    }
+    return true;
+}
+
+
+// извлекаем объект из json по ключу
+static std::string extractObjectByKey(const std::string &json, const std::string &key) {
+    const std::string marker = '"' + key + '"';
+    size_t k = json.find(marker);
+    if (k == std::string::npos) return {};
+    size_t b = json.find('{', k);
+    if (b == std::string::npos) return {};
+    int d = 0;
+    for (size_t i = b; i < json.size(); ++i) {
+        char c = json[i];
+        if (c == '{') d++;
+        else if (c == '}') {
+            d--;
+            if (d == 0) return json.substr(b, i - b + 1);
+        }
+    }
+    return {};
+}
+
+static std::vector<std::pair<float, float>> parseOrdersArray(const std::string &json, const std::string &key) {
+    std::vector<std::pair<float, float>> result;
+    std::string scope = extractObjectByKey(json, "order_book");
+    const std::string &src = scope.empty() ? json : scope;
+    const std::string marker = '"' + key + '"';
+    size_t mpos = src.find(marker);
+    if (mpos == std::string::npos) return result;
+    size_t apos = src.find('[', mpos);
+    if (apos == std::string::npos) return result;
+    int depth = 0;
+    size_t aend = std::string::npos;
+    for (size_t i = apos; i < src.size(); ++i) {
+        char c = src[i];
+        if (c == '[') depth++;
+        else if (c == ']') {
+            depth--;
+            if (depth == 0) { aend = i; break; }
+        }
+    }
+    if (aend == std::string::npos) return result;
+
+    size_t cur = apos;
+    while (true) {
+        size_t objStart = src.find('{', cur);
+        if (objStart == std::string::npos || objStart > aend) break;
+        int d = 0; size_t objEnd = std::string::npos;
+        for (size_t j = objStart; j <= aend; ++j) {
+            char c = src[j];
+            if (c == '{') d++;
+            else if (c == '}') {
+                d--;
+                if (d == 0) { objEnd = j; break; }
+            }
+        }
+        if (objEnd == std::string::npos) break;
+
+        const std::string obj = src.substr(objStart, objEnd - objStart + 1);
+        auto findStringField = [&](const std::string &fname) -> std::optional<std::string> {
+            const std::string fmark = '"' + fname + '"';
+            size_t p = obj.find(fmark);
+            if (p == std::string::npos) return std::nullopt;
+            p = obj.find(':', p);
+            if (p == std::string::npos) return std::nullopt;
+            size_t q1 = obj.find('"', p);
+            if (q1 == std::string::npos) return std::nullopt;
+            size_t q2 = obj.find('"', q1 + 1);
+            if (q2 == std::string::npos) return std::nullopt;
+            return obj.substr(q1 + 1, q2 - q1 - 1);
+        };
+
+        std::optional<std::string> priceStr = findStringField("price");
+        // size <= 0 означает удаление уровня.
+        std::optional<std::string> amtStr = findStringField("size");
+        if (priceStr && amtStr) {
+            char *ep1 = nullptr;
+            char *ep2 = nullptr;
+            float price = (float)std::strtod(priceStr->c_str(), &ep1);
+            float amount = (float)std::strtod(amtStr->c_str(), &ep2);
+            // Добавляем запись даже при amount <= 0, чтобы апдейтер смог удалить уровень.
+            if (price > 0.0f) result.emplace_back(price, amount);
+        }
+        cur = objEnd + 1;
+    }
+    return result;
+}
+
+static std::optional<long long> extractOffset(const std::string &json) {
+    const std::string key = "\"offset\"";
+    size_t p = json.find(key);
+    if (p == std::string::npos) return std::nullopt;
+    p = json.find(':', p);
+    if (p == std::string::npos) return std::nullopt;
+    ++p;
+    while (p < json.size() && (json[p] == ' ' || json[p] == '\t')) ++p;
+    char *ep = nullptr;
+    long long v = std::strtoll(json.c_str() + p, &ep, 10);
+    if (ep == json.c_str() + p) return std::nullopt;
+    return v;
+}
+
+void parseOrderBook(const std::string &json, OrderBookFrame &out) {
+    out.offset = extractOffset(json);
+    out.snapshot = json.find("\"type\":\"snapshot/order_book\"") != std::string::npos;
+    out.bids = parseOrdersArray(json, "bids");
+    out.asks = parseOrdersArray(json, "asks");
+}
+
+} // namespace legacy
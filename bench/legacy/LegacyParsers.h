@@ -0,0 +1,32 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "AccountAllOrdersWS.h"
+
+// Прежние парсеры фидов — только для сравнения в бенчмарках, в бот не собираются.
+// Код сохранён как был, без правок по скорости.
+namespace legacy {
+
+// account_all_orders до перехода на однопроходный разбор: блок "orders" копируется,
+// каждое поле ищется отдельным find от начала объекта. false — тип не snapshot/update
+bool parseAccountOrders(std::string_view json, long long priceScale, long long sizeScale,
+                        std::vector<AccountAllOrdersWS::Order> &changed,
+                        std::vector<AccountAllOrdersWS::OrderDetails> &details);
+
+// order_book до однопроходного разбора: объект order_book копируется на каждую сторону,
+// каждый уровень — substr, поиск полей через find и strtod во float
+struct OrderBookFrame {
+    std::optional<long long> offset;
+    bool snapshot{false};
+    std::vector<std::pair<float, float>> bids; // (price, size)
+    std::vector<std::pair<float, float>> asks;
+};
+
+void parseOrderBook(const std::string &json, OrderBookFrame &out);
+
+} // namespace legacy
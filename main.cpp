@@ -7,6 +7,7 @@
 #include <limits>
 #include <thread>
 #include <vector>
+#include <future>
 #include <curl/curl.h>
 #ifdef _WIN32
 #include <windows.h>
@@ -17,6 +18,8 @@
 #include "MarketDepths/LighterOrderBookWS.h"
 #include "Arbitrage/MarketMaker.h"
 #include "requests/lighter/LighterSigner.h"
+#include "MarketDepths/NetLoop.h"
+#include "requests/http/HttpClient.h"
 // убрал helper — теперь используем метод на LighterRequests
 
 int main() {
@@ -25,6 +28,29 @@ int main() {
     SetConsoleCP(CP_UTF8);
     std::setlocale(LC_ALL, ".UTF-8");
 #endif
+    // Все сокеты (стакан, ордера аккаунта, tx) крутятся на одном io_context, по умолчанию в одном потоке
+    {
+        int netThreads = 1;
+        if (const char *netThreadsEnv = std::getenv("LIGHTER_NET_THREADS"); netThreadsEnv && *netThreadsEnv) {
+            netThreads = std::atoi(netThreadsEnv);
+        }
+        const char *busyPollEnv = std::getenv("LIGHTER_NET_BUSY_POLL");
+        NetLoop::configureShared(netThreads, busyPollEnv && std::string(busyPollEnv) == "1");
+    }
+    // REST: пул curl-хендлов с общими DNS/TLS/соединениями, таймауты из окружения
+    {
+        HttpClient::Config httpCfg;
+        if (const char *env = std::getenv("LIGHTER_HTTP_TIMEOUT_MS"); env && *env) httpCfg.timeoutMs = std::atol(env);
+        if (const char *env = std::getenv("LIGHTER_HTTP_CONNECT_TIMEOUT_MS"); env && *env) httpCfg.connectTimeoutMs = std::atol(env);
+        HttpClient::configure(httpCfg);
+        if (const char *env = std::getenv("LIGHTER_HTTP_TRACE"); env && std::string(env) == "1") {
+            HttpClient::setOnTiming([](const std::string &method, const std::string &reqUrl, const HttpClient::Timing &t) {
+                std::cerr << "[HttpClient] " << method << " " << reqUrl << " total=" << t.totalUs << "us dns=" << t.dnsUs
+                          << " connect=" << t.connectUs << " tls=" << t.tlsUs << " ttfb=" << t.ttfbUs
+                          << (t.reusedConnection ? " reused" : " new") << std::endl;
+            });
+        }
+    }
     // Подписка на все позиции аккаунта и вывод в консоль
     std::string url = "wss://mainnet.zklighter.elliot.ai/stream";
     const char *accEnv = std::getenv("LIGHTER_ACCOUNT_INDEX"); // у них в доке его можно найти по l1 адресу, будет скрин
@@ -74,6 +100,10 @@ int main() {
     // Конфигурация MarketMaker
     const char *mktEnv = std::getenv("LIGHTER_MARKET_INDEX");
     std::string marketIndex = (mktEnv && *mktEnv) ? mktEnv : std::string("71");
+    // Скейлы рынка: amount scale будет в ридми сложная система, price scale аналогично.
+    // Одни и те же для signer'а и для стакана, чтобы цены из книги шли в подпись без пересчёта
+    const long long amountScale = 10;
+    const int priceScale = 100000;
     // Инициализация клиента для ордеров
     const char *baseUrlEnv = std::getenv("LIGHTER_BASE_URL");
     std::string baseUrl = baseUrlEnv && *baseUrlEnv ? baseUrlEnv : std::string("https://mainnet.zklighter.elliot.ai");
@@ -82,17 +112,32 @@ int main() {
     if (!authToken.empty()) req->setAuthToken(authToken);
     // Настройка сайнера из окружения (если доступно) — используем уже считанные переменные
     if (signerPathEnv && *signerPathEnv && apiKeyPrivEnv && *apiKeyPrivEnv && apiKeyIndexEnv && *apiKeyIndexEnv && accEnv && *accEnv) {
+        // Дополнительные ключи того же аккаунта "index:private,index:private" — транзакции раздаются по кругу
+        std::vector<SignerSession::ApiKey> apiKeys{{std::atoi(apiKeyIndexEnv), apiKeyPrivEnv}};
+        if (const char *extraKeysEnv = std::getenv("LIGHTER_EXTRA_API_KEYS"); extraKeysEnv && *extraKeysEnv) {
+            std::stringstream ss(extraKeysEnv);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                const size_t colon = item.find(':');
+                if (colon == std::string::npos) continue;
+                apiKeys.push_back({std::atoi(item.substr(0, colon).c_str()), item.substr(colon + 1)});
+            }
+        }
         req->setSignerConfig(
                 signerPathEnv,
-                apiKeyPrivEnv,
+                apiKeys,
                 (lighterBase.find("mainnet") != std::string::npos) ? 304 : 300,
-                std::atoi(apiKeyIndexEnv),
                 std::atoll(accEnv),
-                10, // amount scale будет в ридми сложная система
-                100000 // price scale аналогично
+                amountScale,
+                priceScale
         );
     }
     req->setMarketIndex(std::atoi(marketIndex.c_str()));
+    if (const char *txRateEnv = std::getenv("LIGHTER_TX_RATE_PER_SEC"); txRateEnv && *txRateEnv) {
+        const double rate = std::atof(txRateEnv);
+        const char *txBurstEnv = std::getenv("LIGHTER_TX_BURST");
+        req->setTxRateLimit(rate, (txBurstEnv && *txBurstEnv) ? std::atof(txBurstEnv) : rate);
+    }
 
     // WS стакан
     LighterOrderBookWS::Config obCfg;
@@ -104,15 +149,17 @@ int main() {
                           "\"channel\":\"order_book/" + marketIndex + "\"" +
                           "}";
     obCfg.depthLimit = 10;
+    obCfg.priceScale = priceScale;
+    obCfg.sizeScale = amountScale;
 
     // для тестов оставлю
     if (!tradeMode) {
         // Режим: просто печатаем стакан и спред
         obCfg.onDepthUpdated = [](const MarketDepth &depth, long long /*offset*/){
-            float bestBid = depth.bids.empty() ? 0.0f : depth.bids.front().first;
-            float bestAsk = depth.asks.empty() ? 0.0f : depth.asks.front().first;
-            float mid = (bestBid + bestAsk) * 0.5f;
-            float spreadPct = (mid > 0.0f && bestAsk > bestBid) ? ((bestAsk - bestBid) / mid) * 100.0f : 0.0f;
+            double bestBid = depth.bidPrice(0);
+            double bestAsk = depth.askPrice(0);
+            double mid = (bestBid + bestAsk) * 0.5;
+            double spreadPct = (mid > 0.0 && bestAsk > bestBid) ? ((bestAsk - bestBid) / mid) * 100.0 : 0.0;
             std::cout << std::fixed << std::setprecision(6)
                       << "bid=" << bestBid << " ask=" << bestAsk << " spread%=" << spreadPct << "\n";
         };
@@ -124,7 +171,9 @@ int main() {
         return 0;
     }
 
-    // Вызов изменения tier аккаунта через LighterRequests (HttpClient внутри)
+    // Вызов изменения tier аккаунта через LighterRequests (HttpClient внутри).
+    // Запрос летит, пока поднимаются стратегия и сокеты; ответ печатаем после запуска
+    std::future<std::string> tierResp;
     {
         const char *accEnv2 = std::getenv("LIGHTER_ACCOUNT_INDEX");
         long long accountIndex = 143858;
@@ -133,8 +182,7 @@ int main() {
 
         if (accountIndex > 0 && !authToken.empty()) {
             try {
-                std::string resp = req->changeAccountTier(accountIndex, newTier);
-                std::cout << "changeAccountTier response: " << resp << "\n";
+                tierResp = req->changeAccountTierAsync(accountIndex, newTier);
             } catch (const std::exception &ex) {
                 std::cerr << "changeAccountTier error: " << ex.what() << "\n";
             }
@@ -151,6 +199,12 @@ int main() {
                    //0.47937
     mmCfg.tickSize = 0.00001f;
     mmCfg.requests = req;
+    if (const char *presignEnv = std::getenv("LIGHTER_PRESIGN_TICKS"); presignEnv && *presignEnv) {
+        mmCfg.presignWindowTicks = std::atoi(presignEnv);
+    }
+    if (const char *cancelAllEnv = std::getenv("LIGHTER_CANCEL_ALL_WINDOW_MS"); cancelAllEnv && *cancelAllEnv) {
+        mmCfg.cancelAllWindowMs = std::atoi(cancelAllEnv);
+    }
     MarketMaker mm(mmCfg);
     mm.start();
 
@@ -165,25 +219,28 @@ int main() {
     aoCfg.url = url;
     aoCfg.accountId = accEnv ? accEnv : "143858";
     aoCfg.authToken = authToken;
-    // колбэк для канала ордеров аккаунта. отдаёт последний ордер по ts
-    aoCfg.onOrdersUpdated = [&mm, marketIndex](const std::unordered_map<int, std::vector<AccountAllOrdersWS::Order>> &byMarket){
-        int mkt = std::atoi(marketIndex.c_str());
-        auto it = byMarket.find(mkt);
-        if (it != byMarket.end()) {
-            const auto &orders = it->second;
-            const AccountAllOrdersWS::Order *best = nullptr;
-            long long bestTs = std::numeric_limits<long long>::min();
-            for (const auto &o : orders) {
-                if (o.timestamp >= bestTs) { best = &o; bestTs = o.timestamp; }
-            }
-            if (best) {
-                mm.updateOrder(*best);
-            }
+    aoCfg.priceScale = priceScale;
+    aoCfg.sizeScale = amountScale;
+    // колбэк для канала ордеров аккаунта: все изменившиеся ордера нашего рынка в порядке прихода —
+    // исполнение рабочего ордера не теряется за более новым обновлением в том же кадре
+    // (чужие и прошлые ордера отсекает сам updateOrder)
+    const int mmMarket = std::atoi(marketIndex.c_str());
+    aoCfg.onOrdersChanged = [&mm, mmMarket](const std::vector<AccountAllOrdersWS::Order> &changed){
+        for (const auto &o : changed) {
+            if (o.market_index == mmMarket) mm.updateOrder(o);
         }
     };
     AccountAllOrdersWS ao(aoCfg);
     ao.start();
 
+    if (tierResp.valid()) {
+        try {
+            std::cout << "changeAccountTier response: " << tierResp.get() << "\n";
+        } catch (const std::exception &ex) {
+            std::cerr << "changeAccountTier error: " << ex.what() << "\n";
+        }
+    }
+
     while (true) {
         std::this_thread::sleep_for(std::chrono::seconds(60000));
     }
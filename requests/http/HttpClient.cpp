@@ -1,5 +1,12 @@
 #include "HttpClient.h"
 #include <stdexcept>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <iostream>
 #include <curl/curl.h>
 
 static size_t curlWriteToStringInternal(void *contents, size_t size, size_t nmemb, void *userp) {
@@ -20,55 +27,420 @@ static std::string buildUrl(const std::string &baseUrl, const std::string &path)
     return url;
 }
 
+namespace {
+
+// Общие на процесс: CURLSH с DNS и TLS-сессиями и стопка свободных easy-хендлов.
+// Соединения в CURLSH не кладём: синхронные запросы идут из потоков вызывающих одновременно
+// с потоком curl_multi, а общий кэш соединений между параллельными потоками curl не поддерживает.
+// Соединение остаётся у хендла (синхронный путь) или у curl_multi (async)
+class CurlPool {
+public:
+    static CurlPool &instance() {
+        static CurlPool pool;
+        return pool;
+    }
+
+    std::shared_ptr<const HttpClient::Config> config() {
+        std::lock_guard<std::mutex> lk(_cfgMtx);
+        return _cfg;
+    }
+    void configure(const HttpClient::Config &cfg) {
+        auto next = std::make_shared<const HttpClient::Config>(cfg);
+        std::lock_guard<std::mutex> lk(_cfgMtx);
+        _cfg = std::move(next);
+    }
+    HttpClient::TimingCallback onTiming() {
+        std::lock_guard<std::mutex> lk(_cfgMtx);
+        return _onTiming;
+    }
+    void setOnTiming(HttpClient::TimingCallback cb) {
+        std::lock_guard<std::mutex> lk(_cfgMtx);
+        _onTiming = std::move(cb);
+    }
+
+    CURL *acquire() {
+        {
+            std::lock_guard<std::mutex> lk(_idleMtx);
+            if (!_idle.empty()) {
+                CURL *h = _idle.back();
+                _idle.pop_back();
+                return h;
+            }
+        }
+        CURL *h = curl_easy_init();
+        if (!h) throw std::runtime_error("curl_easy_init failed");
+        handlesCreated.fetch_add(1);
+        return h;
+    }
+
+    void release(CURL *h, size_t maxIdle) {
+        // reset сбрасывает опции, но не кэши: соединение остаётся у хендла, DNS и сессии — в _share
+        curl_easy_reset(h);
+        {
+            std::lock_guard<std::mutex> lk(_idleMtx);
+            if (_idle.size() < maxIdle) {
+                _idle.push_back(h);
+                return;
+            }
+        }
+        curl_easy_cleanup(h);
+    }
+
+    // Опции, общие для GET и POST
+    void prepare(CURL *h, const HttpClient::Config &cfg, const std::string &url, std::string *response) {
+        curl_easy_setopt(h, CURLOPT_SHARE, _share);
+        curl_easy_setopt(h, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(h, CURLOPT_WRITEFUNCTION, curlWriteToStringInternal);
+        curl_easy_setopt(h, CURLOPT_WRITEDATA, response);
+        curl_easy_setopt(h, CURLOPT_USERAGENT, "MM-BID-ASK/1.0");
+        curl_easy_setopt(h, CURLOPT_NOSIGNAL, 1L); // таймауты из нескольких потоков без SIGALRM
+        curl_easy_setopt(h, CURLOPT_TCP_NODELAY, 1L);
+        curl_easy_setopt(h, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(h, CURLOPT_TCP_KEEPIDLE, cfg.keepAliveIdleSec);
+        curl_easy_setopt(h, CURLOPT_TCP_KEEPINTVL, cfg.keepAliveIntervalSec);
+        curl_easy_setopt(h, CURLOPT_CONNECTTIMEOUT_MS, cfg.connectTimeoutMs);
+        curl_easy_setopt(h, CURLOPT_TIMEOUT_MS, cfg.timeoutMs);
+        if (cfg.http2) {
+            curl_easy_setopt(h, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2TLS);
+            // лучше мультиплекс в живое соединение, чем новое. Только для TLS: там протокол известен
+            // после ALPN, а по открытому http curl ждал бы конца первого ответа
+            if (url.rfind("https://", 0) == 0) curl_easy_setopt(h, CURLOPT_PIPEWAIT, 1L);
+        }
+    }
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> handlesCreated{0};
+    std::atomic<uint64_t> reusedConnections{0};
+    std::atomic<long long> sumTotalUs{0};
+    std::atomic<long long> maxTotalUs{0};
+
+private:
+    CurlPool() : _cfg(std::make_shared<const HttpClient::Config>()) {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        _share = curl_share_init();
+        if (!_share) throw std::runtime_error("curl_share_init failed");
+        curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, &CurlPool::lock);
+        curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, &CurlPool::unlock);
+        curl_share_setopt(_share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    ~CurlPool() {
+        for (CURL *h : _idle) curl_easy_cleanup(h);
+        curl_share_cleanup(_share);
+        curl_global_cleanup();
+    }
+
+    static void lock(CURL *, curl_lock_data data, curl_lock_access, void *userp) {
+        static_cast<CurlPool *>(userp)->_shareMtx[data % kShareLocks].lock();
+    }
+    static void unlock(CURL *, curl_lock_data data, void *userp) {
+        static_cast<CurlPool *>(userp)->_shareMtx[data % kShareLocks].unlock();
+    }
+
+    static constexpr int kShareLocks = CURL_LOCK_DATA_LAST;
+    std::mutex _shareMtx[kShareLocks];
+    CURLSH *_share{nullptr};
+
+    std::mutex _idleMtx;
+    std::vector<CURL *> _idle;
+
+    std::mutex _cfgMtx;
+    std::shared_ptr<const HttpClient::Config> _cfg;
+    HttpClient::TimingCallback _onTiming;
+};
+
+thread_local HttpClient::Timing tlsLastTiming;
+
+HttpClient::Timing readTiming(CURL *h) {
+    curl_off_t dns = 0, connect = 0, app = 0, pre = 0, start = 0, total = 0;
+    long connects = 0, version = 0;
+    curl_easy_getinfo(h, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+    curl_easy_getinfo(h, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(h, CURLINFO_APPCONNECT_TIME_T, &app);
+    curl_easy_getinfo(h, CURLINFO_PRETRANSFER_TIME_T, &pre);
+    curl_easy_getinfo(h, CURLINFO_STARTTRANSFER_TIME_T, &start);
+    curl_easy_getinfo(h, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(h, CURLINFO_NUM_CONNECTS, &connects);
+    curl_easy_getinfo(h, CURLINFO_HTTP_VERSION, &version);
+    // curl отдаёт накопленные отметки от начала запроса — переводим в длительности этапов
+    HttpClient::Timing t;
+    t.dnsUs = dns;
+    t.connectUs = std::max<long long>(0, connect - dns);
+    t.tlsUs = app > 0 ? std::max<long long>(0, app - connect) : 0;
+    t.ttfbUs = std::max<long long>(0, start - pre);
+    t.totalUs = total;
+    t.reusedConnection = connects == 0;
+    t.httpVersion = version;
+    return t;
+}
+
+void setPostBody(CURL *h, const std::string &body) {
+    curl_easy_setopt(h, CURLOPT_POST, 1L);
+    if (!body.empty()) {
+        curl_easy_setopt(h, CURLOPT_POSTFIELDS, body.c_str());
+        curl_easy_setopt(h, CURLOPT_POSTFIELDSIZE, (long)body.size());
+    } else {
+        curl_easy_setopt(h, CURLOPT_POSTFIELDS, "");
+        curl_easy_setopt(h, CURLOPT_POSTFIELDSIZE, 0L);
+    }
+}
+
+// Учесть завершённый запрос и вернуть хендл в пул при любом исходе; ошибка — исключением
+void finish(CurlPool &pool, CURL *h, const HttpClient::Config &cfg, const char *method,
+            const std::string &url, CURLcode res) {
+    pool.requests.fetch_add(1);
+    if (res != CURLE_OK) {
+        pool.failures.fetch_add(1);
+        pool.release(h, cfg.maxIdleHandles);
+        throw std::runtime_error(std::string("curl_easy_perform(") + method + ") failed: " + curl_easy_strerror(res));
+    }
+    const HttpClient::Timing t = readTiming(h);
+    pool.release(h, cfg.maxIdleHandles);
+    tlsLastTiming = t;
+    if (t.reusedConnection) pool.reusedConnections.fetch_add(1);
+    pool.sumTotalUs.fetch_add(t.totalUs);
+    long long prev = pool.maxTotalUs.load();
+    while (t.totalUs > prev && !pool.maxTotalUs.compare_exchange_weak(prev, t.totalUs)) {}
+    if (auto cb = pool.onTiming()) cb(method, url, t);
+}
+
+std::string perform(CurlPool &pool, CURL *h, const HttpClient::Config &cfg, const char *method,
+                    const std::string &url, std::string &response) {
+    finish(pool, h, cfg, method, url, curl_easy_perform(h));
+    return std::move(response);
+}
+
+// Поток curl_multi: принимает подготовленные хендлы, гоняет их вместе и отдаёт итоги в Completion
+class CurlMulti {
+public:
+    struct Request {
+        CURL *handle{nullptr};
+        std::shared_ptr<const HttpClient::Config> cfg;
+        const char *method{""};
+        std::string url;
+        std::string body;          // POSTFIELDS не копируется curl — живёт здесь
+        curl_slist *headers{nullptr};
+        std::string response;
+        HttpClient::Completion done;
+    };
+
+    static CurlMulti &instance() {
+        static CurlMulti multi;
+        return multi;
+    }
+
+    void submit(std::unique_ptr<Request> r) {
+        {
+            std::lock_guard<std::mutex> lk(_mtx);
+            _incoming.push_back(std::move(r));
+        }
+        curl_multi_wakeup(_multi);
+    }
+
+private:
+    CurlMulti() : _pool(CurlPool::instance()) { // пул создан раньше — и разрушится позже
+        _multi = curl_multi_init();
+        if (!_multi) throw std::runtime_error("curl_multi_init failed");
+        curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        _worker = std::thread([this]() { run(); });
+    }
+
+    ~CurlMulti() {
+        {
+            std::lock_guard<std::mutex> lk(_mtx);
+            _stopping = true;
+        }
+        curl_multi_wakeup(_multi);
+        if (_worker.joinable()) _worker.join();
+        curl_multi_cleanup(_multi);
+    }
+
+    void run() {
+        std::vector<std::unique_ptr<Request>> fresh;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lk(_mtx);
+                if (_stopping) break;
+                while (!_incoming.empty()) {
+                    fresh.push_back(std::move(_incoming.front()));
+                    _incoming.pop_front();
+                }
+            }
+            for (auto &r : fresh) {
+                if (curl_multi_add_handle(_multi, r->handle) != CURLM_OK) {
+                    complete(std::move(r), CURLE_FAILED_INIT);
+                    continue;
+                }
+                _active.push_back(std::move(r));
+            }
+            fresh.clear();
+
+            int running = 0;
+            curl_multi_perform(_multi, &running);
+            int left = 0;
+            while (CURLMsg *msg = curl_multi_info_read(_multi, &left)) {
+                if (msg->msg != CURLMSG_DONE) continue;
+                CURL *h = msg->easy_handle;
+                const CURLcode res = msg->data.result;
+                curl_multi_remove_handle(_multi, h);
+                auto it = std::find_if(_active.begin(), _active.end(),
+                                       [h](const std::unique_ptr<Request> &r) { return r->handle == h; });
+                if (it == _active.end()) continue;
+                std::unique_ptr<Request> r = std::move(*it);
+                _active.erase(it);
+                complete(std::move(r), res);
+            }
+            curl_multi_poll(_multi, nullptr, 0, 1000, nullptr);
+        }
+        // остановка: незавершённые получают ошибку, хендлы — обратно в пул
+        for (auto &r : _active) curl_multi_remove_handle(_multi, r->handle);
+        {
+            std::lock_guard<std::mutex> lk(_mtx);
+            for (auto &r : _incoming) _active.push_back(std::move(r));
+            _incoming.clear();
+        }
+        for (auto &r : _active) complete(std::move(r), CURLE_ABORTED_BY_CALLBACK);
+        _active.clear();
+    }
+
+    void complete(std::unique_ptr<Request> r, CURLcode res) {
+        std::exception_ptr error;
+        try {
+            finish(_pool, r->handle, *r->cfg, r->method, r->url, res);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        if (r->headers) curl_slist_free_all(r->headers);
+        if (!r->done) return;
+        try {
+            r->done(error ? std::string() : std::move(r->response), error);
+        } catch (const std::exception &ex) {
+            std::cerr << "[HttpClient] async completion threw: " << ex.what() << std::endl;
+        }
+    }
+
+    CurlPool &_pool;
+    CURLM *_multi{nullptr};
+    std::thread _worker;
+    std::mutex _mtx; // _incoming, _stopping
+    std::deque<std::unique_ptr<Request>> _incoming;
+    bool _stopping{false};
+    std::vector<std::unique_ptr<Request>> _active; // только поток run()
+};
+
+// Обернуть Completion в promise
+std::pair<std::future<std::string>, HttpClient::Completion> makeFuture() {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    auto future = promise->get_future();
+    return {std::move(future), [promise](std::string response, std::exception_ptr error) {
+        if (error) promise->set_exception(error);
+        else promise->set_value(std::move(response));
+    }};
+}
+
+} // namespace
+
+void HttpClient::configure(const Config &cfg) {
+    CurlPool::instance().configure(cfg);
+}
+
+void HttpClient::setOnTiming(TimingCallback cb) {
+    CurlPool::instance().setOnTiming(std::move(cb));
+}
+
+HttpClient::Timing HttpClient::lastTiming() {
+    return tlsLastTiming;
+}
+
+HttpClient::Stats HttpClient::stats() {
+    CurlPool &pool = CurlPool::instance();
+    Stats s;
+    s.requests = pool.requests.load();
+    s.failures = pool.failures.load();
+    s.handlesCreated = pool.handlesCreated.load();
+    s.reusedConnections = pool.reusedConnections.load();
+    const uint64_t ok = s.requests - s.failures;
+    s.avgTotalUs = ok ? pool.sumTotalUs.load() / (long long) ok : 0;
+    s.maxTotalUs = pool.maxTotalUs.load();
+    return s;
+}
+
 std::string HttpClient::httpGet(const std::string &baseUrl, const std::string &pathWithQuery) {
-    CURL *curl = curl_easy_init();
-    if (!curl) throw std::runtime_error("curl_easy_init failed");
+    CurlPool &pool = CurlPool::instance();
+    const auto cfg = pool.config();
+    CURL *curl = pool.acquire();
     std::string response;
     std::string url = buildUrl(baseUrl, pathWithQuery);
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    pool.prepare(curl, *cfg, url, &response);
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curlWriteToStringInternal);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "MM-BID-ASK/1.0");
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        curl_easy_cleanup(curl);
-        throw std::runtime_error(std::string("curl_easy_perform(GET) failed: ") + curl_easy_strerror(res));
-    }
-    curl_easy_cleanup(curl);
-    return response;
+    return perform(pool, curl, *cfg, "GET", url, response);
 }
-// todo вот тут надо выжить все соки, так как запрос идёт максимально долго и мм (он есть) перебивает просто
+// Хендл и соединение из пула: тёплый запрос — без DNS, TCP и TLS
 std::string HttpClient::httpPost(const std::string &baseUrl, const std::string &path,
                                  const std::string &body,
                                  const std::vector<std::string> &headersIn) {
-    CURL *curl = curl_easy_init();
-    if (!curl) throw std::runtime_error("curl_easy_init failed");
+    CurlPool &pool = CurlPool::instance();
+    const auto cfg = pool.config();
+    CURL *curl = pool.acquire();
     std::string response;
     std::string url = buildUrl(baseUrl, path);
     struct curl_slist *headers = nullptr;
     for (const auto &h : headersIn) headers = curl_slist_append(headers, h.c_str());
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    pool.prepare(curl, *cfg, url, &response);
     if (headers) curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curlWriteToStringInternal);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "MM-BID-ASK/1.0");
-    if (!body.empty()) {
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body.size());
-    } else {
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
-    }
-    CURLcode res = curl_easy_perform(curl);
-    if (headers) curl_slist_free_all(headers);
-    if (res != CURLE_OK) {
-        curl_easy_cleanup(curl);
-        throw std::runtime_error(std::string("curl_easy_perform(POST) failed: ") + curl_easy_strerror(res));
+    setPostBody(curl, body);
+    try {
+        std::string out = perform(pool, curl, *cfg, "POST", url, response);
+        if (headers) curl_slist_free_all(headers);
+        return out;
+    } catch (...) {
+        if (headers) curl_slist_free_all(headers);
+        throw;
     }
-    curl_easy_cleanup(curl);
-    return response;
 }
 
+void HttpClient::httpGetAsync(const std::string &baseUrl, const std::string &pathWithQuery, Completion done) {
+    CurlPool &pool = CurlPool::instance();
+    auto r = std::make_unique<CurlMulti::Request>();
+    r->cfg = pool.config();
+    r->method = "GET";
+    r->url = buildUrl(baseUrl, pathWithQuery);
+    r->done = std::move(done);
+    r->handle = pool.acquire();
+    pool.prepare(r->handle, *r->cfg, r->url, &r->response);
+    curl_easy_setopt(r->handle, CURLOPT_FOLLOWLOCATION, 1L);
+    CurlMulti::instance().submit(std::move(r));
+}
 
+void HttpClient::httpPostAsync(const std::string &baseUrl, const std::string &path, const std::string &body,
+                               const std::vector<std::string> &headersIn, Completion done) {
+    CurlPool &pool = CurlPool::instance();
+    auto r = std::make_unique<CurlMulti::Request>();
+    r->cfg = pool.config();
+    r->method = "POST";
+    r->url = buildUrl(baseUrl, path);
+    r->body = body;
+    r->done = std::move(done);
+    for (const auto &h : headersIn) r->headers = curl_slist_append(r->headers, h.c_str());
+    r->handle = pool.acquire();
+    pool.prepare(r->handle, *r->cfg, r->url, &r->response);
+    if (r->headers) curl_easy_setopt(r->handle, CURLOPT_HTTPHEADER, r->headers);
+    setPostBody(r->handle, r->body);
+    CurlMulti::instance().submit(std::move(r));
+}
+
+std::future<std::string> HttpClient::httpGetAsync(const std::string &baseUrl, const std::string &pathWithQuery) {
+    auto [future, done] = makeFuture();
+    httpGetAsync(baseUrl, pathWithQuery, std::move(done));
+    return std::move(future);
+}
+
+std::future<std::string> HttpClient::httpPostAsync(const std::string &baseUrl, const std::string &path,
+                                                   const std::string &body, const std::vector<std::string> &headers) {
+    auto [future, done] = makeFuture();
+    httpPostAsync(baseUrl, path, body, headers, std::move(done));
+    return std::move(future);
+}
@@ -2,8 +2,59 @@
 
 #include <string>
 #include <vector>
+#include <functional>
+#include <cstdint>
+#include <future>
+#include <exception>
 
+// Синхронный HTTP поверх пула curl easy-хендлов: хендлы переиспользуются вместе со своими
+// соединениями, DNS и TLS-сессии общие (CURLSH), поэтому повторный запрос к тому же хосту
+// не платит за resolve/connect, а новое соединение — за полный handshake. HTTP/2 по TLS, если сервер согласится.
+// Async-варианты идут через curl_multi в отдельном потоке: независимые запросы летят
+// параллельно (по HTTP/2 — в одном соединении), и пачка ждёт самый медленный, а не сумму.
 class HttpClient {
+public:
+    struct Config {
+        long connectTimeoutMs = 3000;
+        long timeoutMs = 10000;        // весь запрос целиком; 0 — без ограничения
+        long keepAliveIdleSec = 30;    // TCP keepalive: первая проба после простоя
+        long keepAliveIntervalSec = 15;
+        bool http2 = true;
+        size_t maxIdleHandles = 8;     // лишние хендлы после запроса закрываются
+    };
+
+    // Разбивка одного запроса, мкс от его начала до конца каждого этапа — в длительностях этапов
+    struct Timing {
+        long long dnsUs{0};
+        long long connectUs{0};   // TCP
+        long long tlsUs{0};
+        long long ttfbUs{0};      // от отправки запроса до первого байта ответа
+        long long totalUs{0};
+        bool reusedConnection{false};
+        long httpVersion{0};      // CURL_HTTP_VERSION_*
+    };
+
+    struct Stats {
+        uint64_t requests{0};
+        uint64_t failures{0};
+        uint64_t handlesCreated{0};
+        uint64_t reusedConnections{0};
+        long long avgTotalUs{0};
+        long long maxTotalUs{0};
+    };
+
+    using TimingCallback = std::function<void(const std::string &method, const std::string &url, const Timing &)>;
+    // Итог async-запроса: ответ или ошибка (error != nullptr). Зовётся в потоке curl_multi — коротко
+    using Completion = std::function<void(std::string response, std::exception_ptr error)>;
+
+    // До первого запроса или между ними — новые настройки применяются к следующим запросам
+    static void configure(const Config &cfg);
+    // Вызывается после каждого успешного запроса в потоке запроса
+    static void setOnTiming(TimingCallback cb);
+    // Разбивка последнего запроса этого потока
+    static Timing lastTiming();
+    static Stats stats();
+
 protected:
     // Обычные curl запросы, переиспользую логику
 
@@ -15,6 +66,12 @@ protected:
             const std::string &body,
             const std::vector<std::string> &headers
     );
-};
 
+    static void httpGetAsync(const std::string &baseUrl, const std::string &pathWithQuery, Completion done);
+    static void httpPostAsync(const std::string &baseUrl, const std::string &path, const std::string &body,
+                              const std::vector<std::string> &headers, Completion done);
 
+    static std::future<std::string> httpGetAsync(const std::string &baseUrl, const std::string &pathWithQuery);
+    static std::future<std::string> httpPostAsync(const std::string &baseUrl, const std::string &path,
+                                                  const std::string &body, const std::vector<std::string> &headers);
+};
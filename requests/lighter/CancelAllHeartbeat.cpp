@@ -0,0 +1,136 @@
+#include "CancelAllHeartbeat.h"
+#include "../../MarketDepths/NetLoop.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+
+#include <boost/asio/steady_timer.hpp>
+
+namespace net = boost::asio;
+
+static long long nowEpochMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+struct CancelAllHeartbeat::Impl : std::enable_shared_from_this<CancelAllHeartbeat::Impl> {
+    Config cfg;
+    net::steady_timer timer;
+
+    std::mutex mtx; // running/consecutiveFailures/gaveUp, вызов renew
+    bool running{false};
+    bool gaveUp{false};
+    int consecutiveFailures{0};
+
+    std::atomic<uint64_t> renewals{0};
+    std::atomic<uint64_t> confirmed{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> skipped{0};
+    std::atomic<long long> deadlineEpochMs{0};
+
+    explicit Impl(Config c)
+            : cfg(std::move(c)), timer((cfg.loop ? *cfg.loop : NetLoop::shared()).context()) {}
+
+    // под mtx
+    void armLocked(int delayMs) {
+        if (!running) return;
+        timer.expires_after(std::chrono::milliseconds(delayMs));
+        timer.async_wait([self = shared_from_this()](const boost::system::error_code &ec) {
+            if (ec) return;
+            self->tick();
+        });
+    }
+
+    // под mtx; true — только что сдались, владельцу звать onGaveUp (уже без лока)
+    bool failLocked(const std::string &why) {
+        failures.fetch_add(1);
+        ++consecutiveFailures;
+        std::cerr << "[CancelAllHeartbeat] renew failed (" << consecutiveFailures << "): " << why << std::endl;
+        if (consecutiveFailures < cfg.maxFailures || !running) return false;
+        std::cerr << "[CancelAllHeartbeat] giving up, resting orders are no longer protected" << std::endl;
+        running = false;
+        gaveUp = true;
+        timer.cancel();
+        return true;
+    }
+
+    void notifyGaveUp() {
+        if (cfg.onGaveUp) cfg.onGaveUp();
+    }
+
+    void tick() {
+        bool gave = false;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (!running) return;
+            if (cfg.healthy && !cfg.healthy()) {
+                skipped.fetch_add(1);
+                armLocked(cfg.renewMs);
+                return;
+            }
+            const long long at = nowEpochMs() + cfg.windowMs;
+            renewals.fetch_add(1);
+            try {
+                std::weak_ptr<Impl> weak = shared_from_this();
+                cfg.renew(at, [weak, at](bool ok) {
+                    if (auto self = weak.lock()) self->onResult(ok, at);
+                });
+            } catch (const std::exception &ex) {
+                gave = failLocked(ex.what());
+            }
+            armLocked(cfg.renewMs);
+        }
+        if (gave) notifyGaveUp();
+    }
+
+    void onResult(bool ok, long long at) {
+        std::unique_lock<std::mutex> lk(mtx);
+        if (!ok) {
+            const bool gave = failLocked("rejected");
+            lk.unlock();
+            if (gave) notifyGaveUp();
+            return;
+        }
+        consecutiveFailures = 0;
+        confirmed.fetch_add(1);
+        // ответы могут прийти не по порядку — держим самый поздний срок
+        long long prev = deadlineEpochMs.load();
+        while (at > prev && !deadlineEpochMs.compare_exchange_weak(prev, at)) {}
+    }
+};
+
+CancelAllHeartbeat::CancelAllHeartbeat(Config cfg) : _impl(std::make_shared<Impl>(std::move(cfg))) {}
+
+CancelAllHeartbeat::~CancelAllHeartbeat() { stop(); }
+
+void CancelAllHeartbeat::start() {
+    std::lock_guard<std::mutex> lk(_impl->mtx);
+    if (_impl->running) return;
+    _impl->running = true;
+    _impl->gaveUp = false;
+    _impl->consecutiveFailures = 0;
+    _impl->armLocked(0);
+}
+
+void CancelAllHeartbeat::stop() {
+    std::lock_guard<std::mutex> lk(_impl->mtx);
+    _impl->running = false;
+    _impl->timer.cancel();
+}
+
+CancelAllHeartbeat::Stats CancelAllHeartbeat::stats() const {
+    Stats s;
+    {
+        std::lock_guard<std::mutex> lk(_impl->mtx);
+        s.running = _impl->running;
+        s.gaveUp = _impl->gaveUp;
+    }
+    s.renewals = _impl->renewals.load();
+    s.confirmed = _impl->confirmed.load();
+    s.failures = _impl->failures.load();
+    s.skipped = _impl->skipped.load();
+    s.deadlineEpochMs = _impl->deadlineEpochMs.load();
+    return s;
+}
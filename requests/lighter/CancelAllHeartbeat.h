@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+class NetLoop;
+
+// Dead-man switch: каждые renewMs переносим запланированный cancel-all на now + windowMs.
+// Упал процесс, завис поток или протух фид (healthy() == false) — продления прекращаются,
+// и биржа сама снимает все ордера не позже чем через windowMs. Таймер — на NetLoop.
+class CancelAllHeartbeat {
+public:
+    struct Config {
+        int windowMs = 10000;   // через сколько после последнего продления снимутся ордера
+        int renewMs = 3000;     // период продления, заметно меньше windowMs
+        int maxFailures = 3;    // подряд отклонённых продлений — останавливаемся (биржа не принимает)
+        NetLoop *loop = nullptr; // nullptr — NetLoop::shared()
+        std::function<bool()> healthy; // false — не продлевать (пусть ордера снимутся)
+        // Отправить scheduled cancel-all на момент atEpochMs; done(ok) — итог от биржи.
+        // Зовётся под внутренним локом: done синхронно отсюда не вызывать; ошибка — исключением
+        std::function<void(long long atEpochMs, std::function<void(bool ok)> done)> renew;
+        // maxFailures продлений подряд не прошли, продления остановлены: ордера больше не защищены,
+        // владелец должен перестать котировать. Зовётся один раз, вне внутреннего лока, из потока NetLoop
+        std::function<void()> onGaveUp;
+    };
+
+    struct Stats {
+        bool running{false};
+        uint64_t renewals{0};    // отправлено продлений
+        uint64_t confirmed{0};   // биржа приняла
+        uint64_t failures{0};    // отклонено или не отправлено
+        uint64_t skipped{0};     // пропущено из-за healthy() == false
+        bool gaveUp{false};      // остановлен после maxFailures отказов подряд
+        long long deadlineEpochMs{0}; // последний подтверждённый момент снятия
+    };
+
+    explicit CancelAllHeartbeat(Config cfg);
+    ~CancelAllHeartbeat();
+
+    // Первое продление — сразу
+    void start();
+    // Больше не продлевать; уже запланированный cancel-all сработает в свой срок
+    void stop();
+
+    Stats stats() const;
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> _impl; // живёт, пока на него смотрят таймер и колбэки итогов
+};
@@ -6,17 +6,41 @@
 #include <cstdlib>
 #include <iostream>
 #include <cmath>
+#include <limits>
+#include <thread>
 
-LighterRequests::LighterRequests()
-    : _baseUrl("https://mainnet.zklighter.elliot.ai"),
-      _orderBookPath("/api/v1/orderBookOrders"),
-      _sendTxPath("/api/v1/sendTx") {
-}
+#include "../../MarketDepths/FixedPoint.h"
+
+LighterRequests::LighterRequests() : LighterRequests("https://mainnet.zklighter.elliot.ai") {}
 
 LighterRequests::LighterRequests(const std::string &baseUrl)
     : _baseUrl(baseUrl),
       _orderBookPath("/api/v1/orderBookOrders"),
       _sendTxPath("/api/v1/sendTx") {
+    ModifyCoalescer::Config mcfg;
+    mcfg.txType = TX_TYPE_MODIFY_ORDER;
+    mcfg.send = [this](const std::string &id, long long orderIndex, const ModifyCoalescer::Intent &intent,
+                       TxAckTracker::Callback done) {
+        // очередь лимита — после схлопывания: ожидание токена тоже считается «в полёте»
+        schedule(TxScheduler::Priority::Modify, id, TX_TYPE_MODIFY_ORDER, std::move(done),
+                 [this, id, orderIndex, intent](TxAckTracker::Callback ack) {
+                     dispatchModifyOrder(id, orderIndex, intent.baseAmount, intent.price, std::move(ack));
+                 });
+    };
+    _modifyCoalescer = std::make_unique<ModifyCoalescer>(mcfg);
+}
+
+LighterRequests::~LighterRequests() {
+    // фоновые потоки ходят в signer, nonce и сокет — гасим их раньше остальных полей.
+    // Продления dead-man switch и очередь лимита ставят задачи в конвейер; конвейер — его выдача nonce дёргает лестницу;
+    // затем отвязываем лестницу от nonce. Очередь лимита отказывает своим задачам, и их владельцы
+    // могут тут же прислать следующие — после _stopping они отклоняются, не трогая очередь
+    _stopping.store(true);
+    _cancelAllHeartbeat.reset();
+    _scheduler.reset();
+    if (_pipeline) _pipeline->stop();
+    if (_nonces) _nonces->setOnChanged({});
+    _ladder.reset();
 }
 
 void LighterRequests::setBaseUrl(const std::string &url) { _baseUrl = url; }
@@ -34,20 +58,65 @@ void LighterRequests::setSignerConfig(const std::string &dllPath,
                                       long long accountIndex,
                                       long long baseAmountScale,
                                       int priceScale) {
-    _signerDllPath = dllPath;
-    _apiKeyPrivate = apiKeyPrivateHex;
+    setSignerConfig(dllPath, {SignerSession::ApiKey{apiKeyIndex, apiKeyPrivateHex}}, chainId, accountIndex,
+                    baseAmountScale, priceScale);
+}
+
+void LighterRequests::setSignerConfig(const std::string &dllPath,
+                                      const std::vector<SignerSession::ApiKey> &apiKeys,
+                                      int chainId,
+                                      long long accountIndex,
+                                      long long baseAmountScale,
+                                      int priceScale) {
     _chainId = chainId;
-    _apiKeyIndex = apiKeyIndex;
     _accountIndex = accountIndex;
     _baseAmountScale = baseAmountScale;
     _priceScale = priceScale;
+
+    // Библиотека и клиенты — один раз здесь, на старте, а не в каждом ордере
+    SignerSession::Config scfg;
+    scfg.dllPath = dllPath;
+    scfg.url = _baseUrl;
+    scfg.apiKeys = apiKeys;
+    scfg.chainId = chainId;
+    scfg.accountIndex = accountIndex;
+    _signer = std::make_unique<SignerSession>(scfg);
+    if (auto err = _signer->open()) {
+        std::cerr << "[LighterRequests] signer init failed, retry on first order: " << *err << std::endl;
+    }
+
+    // nonce всех ключей читаются в фоне сразу, к первому ордеру они уже в памяти
+    NonceManager::Config ncfg;
+    ncfg.apiKeyIndices = _signer->apiKeyIndices();
+    ncfg.fetch = [this](int apiKeyIndex) { return fetchNextNonce(apiKeyIndex); };
+    ncfg.fetchAsync = [this](int apiKeyIndex) { return fetchNextNonceAsync(apiKeyIndex); };
+    _nonces = std::make_unique<NonceManager>(ncfg);
+}
+
+bool LighterRequests::signerReady() {
+    if (!_signer) throw std::runtime_error("signer не настроен: нужен setSignerConfig");
+    return _signer->ensureReady();
+}
+
+SignerSession::Stats LighterRequests::signerStats() const {
+    return _signer ? _signer->stats() : SignerSession::Stats{};
+}
+
+NonceManager::Stats LighterRequests::nonceStats() const {
+    return _nonces ? _nonces->stats() : NonceManager::Stats{};
+}
+
+NonceManager &LighterRequests::nonces() {
+    if (!_nonces) throw std::runtime_error("signer не настроен: нужен setSignerConfig");
+    return *_nonces;
 }
 
 void LighterRequests::setMarketIndex(int marketIndex) { _marketIndex = marketIndex; }
 
 // Парсер стакана
-static std::vector<std::pair<float, float> > parseOrdersArray(const std::string &json, const std::string &key) {
-    std::vector<std::pair<float, float> > result;
+static std::vector<PriceLevel> parseOrdersArray(const std::string &json, const std::string &key,
+                                                long long priceScale, long long sizeScale) {
+    std::vector<PriceLevel> result;
     const std::string marker = '"' + key + '"';
     size_t mpos = json.find(marker);
     if (mpos == std::string::npos) return result;
@@ -108,10 +177,11 @@ static std::vector<std::pair<float, float> > parseOrdersArray(const std::string
         // Используем доступную ликвидность
         std::optional<std::string> amtStr = findStringField("remaining_base_amount");
         if (priceStr && amtStr) {
-            char *ep = nullptr;
-            float price = (float) std::strtod(priceStr->c_str(), &ep);
-            float amount = (float) std::strtod(amtStr->c_str(), &ep);
-            if (price > 0.0f && amount > 0.0f) result.emplace_back(price, amount);
+            PriceLevel lvl;
+            if (fixedpoint::parseDecimal(*priceStr, priceScale, lvl.price) &&
+                fixedpoint::parseDecimal(*amtStr, sizeScale, lvl.size)) {
+                if (lvl.price > 0 && lvl.size > 0) result.push_back(lvl);
+            }
         }
 
         cur = objEnd + 1;
@@ -119,13 +189,10 @@ static std::vector<std::pair<float, float> > parseOrdersArray(const std::string
     return result;
 }
 
-MarketDepth LighterRequests::parseMarketDepthJson(const std::string &json) {
-    MarketDepth depth;
-    depth.bids = parseOrdersArray(json, "bids");
-    depth.asks = parseOrdersArray(json, "asks");
-
-    std::sort(depth.bids.begin(), depth.bids.end(), [](const auto &l, const auto &r) { return l.first > r.first; });
-    std::sort(depth.asks.begin(), depth.asks.end(), [](const auto &l, const auto &r) { return l.first < r.first; });
+MarketDepth LighterRequests::parseMarketDepthJson(const std::string &json, long long priceScale, long long sizeScale) {
+    MarketDepth depth(priceScale, sizeScale);
+    depth.snapshot(parseOrdersArray(json, "bids", priceScale, sizeScale),
+                   parseOrdersArray(json, "asks", priceScale, sizeScale));
     return depth;
 }
 
@@ -150,10 +217,10 @@ static std::optional<long long> parseNonceFromJson(const std::string &json) {
     return v;
 }
 
-long long LighterRequests::fetchNextNonce() {
+long long LighterRequests::fetchNextNonce(int apiKeyIndex) {
     // По API lighter: GET /api/v1/nextNonce?account_index=<>&api_key_index=<>
     std::ostringstream path;
-    path << "/api/v1/nextNonce?account_index=" << _accountIndex << "&api_key_index=" << _apiKeyIndex;
+    path << "/api/v1/nextNonce?account_index=" << _accountIndex << "&api_key_index=" << apiKeyIndex;
 
     std::vector<std::string> headers;
     const std::string token = _authToken ? _authToken.value() : std::string(std::getenv("LIGHTER_AUTH_TOKEN"));
@@ -166,15 +233,22 @@ long long LighterRequests::fetchNextNonce() {
     return *n;
 }
 
-long long LighterRequests::acquireNextNonce() {
-    std::lock_guard<std::mutex> lk(_nonceMtx);
-    if (!_nonceInitialized) {
-        _nextNonceCached = fetchNextNonce();
-        _nonceInitialized = true;
-    }
-    long long current = _nextNonceCached;
-    ++_nextNonceCached;
-    return current;
+std::future<long long> LighterRequests::fetchNextNonceAsync(int apiKeyIndex) {
+    std::ostringstream path;
+    path << "/api/v1/nextNonce?account_index=" << _accountIndex << "&api_key_index=" << apiKeyIndex;
+    auto promise = std::make_shared<std::promise<long long>>();
+    auto future = promise->get_future();
+    HttpClient::httpGetAsync(_baseUrl, path.str(), [promise](std::string resp, std::exception_ptr error) {
+        if (error) return promise->set_exception(error);
+        auto n = parseNonceFromJson(resp);
+        if (!n.has_value()) {
+            promise->set_exception(std::make_exception_ptr(
+                    std::runtime_error("failed to parse nextNonce response: " + resp)));
+            return;
+        }
+        promise->set_value(*n);
+    });
+    return future;
 }
 
 int LighterRequests::getAcceptablePriceInt(const std::optional<double> &price,
@@ -204,12 +278,41 @@ int LighterRequests::getAcceptablePriceInt(const std::optional<double> &price,
 
 
 MarketDepth LighterRequests::fetchMarketDepth(const std::string &symbol, int limit) {
+    if (_priceScale <= 0 || _baseAmountScale <= 0) {
+        throw std::runtime_error("priceScale/baseAmountScale не заданы (<= 0)");
+    }
     std::string raw = fetchMarketDepthRaw(symbol, limit);
-    return parseMarketDepthJson(raw);
+    return parseMarketDepthJson(raw, _priceScale, _baseAmountScale);
+}
+
+std::future<MarketDepth> LighterRequests::fetchMarketDepthAsync(const std::string &symbol, int limit) {
+    if (_priceScale <= 0 || _baseAmountScale <= 0) {
+        throw std::runtime_error("priceScale/baseAmountScale не заданы (<= 0)");
+    }
+    std::ostringstream path;
+    path << _orderBookPath << "?market_id=" << symbol << "&limit=" << limit;
+    auto promise = std::make_shared<std::promise<MarketDepth>>();
+    auto future = promise->get_future();
+    const long long priceScale = _priceScale;
+    const long long sizeScale = _baseAmountScale;
+    HttpClient::httpGetAsync(_baseUrl, path.str(),
+                             [promise, priceScale, sizeScale](std::string resp, std::exception_ptr error) {
+        if (error) return promise->set_exception(error);
+        try {
+            promise->set_value(parseMarketDepthJson(resp, priceScale, sizeScale));
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
 }
 
 void LighterRequests::ensureTxWs() {
-    if (_txWs) return;
+    // зовётся и из потока стратегии, и из пула подписи: создаём ровно один раз
+    std::call_once(_txWsOnce, [this]() { createTxWs(); });
+}
+
+void LighterRequests::createTxWs() {
     std::string wssUrl = _baseUrl;
     if (wssUrl.rfind("https://", 0) == 0) {
         wssUrl.replace(0, 5, "wss");
@@ -221,26 +324,54 @@ void LighterRequests::ensureTxWs() {
     const std::string token = _authToken ? _authToken.value() : std::string(std::getenv("LIGHTER_AUTH_TOKEN"));
     if (!token.empty()) headers.emplace_back(std::string("Authorization: Bearer ") + token);
 
+    TxAckTracker::Config acfg;
+    acfg.timeoutMs = _txAckTimeoutMs;
+    acfg.onAck = [this](const TxAck &ack) {
+        const NonceLease lease{ack.apiKeyIndex, ack.nonce};
+        if (ack.status == TxAck::Status::Accepted) {
+            if (_nonces) _nonces->onAccepted(lease);
+            return;
+        }
+        if (ack.status == TxAck::Status::RateLimited) scheduler().onThrottled();
+        std::cerr << "[LighterTxWS] tx " << ack.id << " type=" << ack.txType << " key=" << ack.apiKeyIndex
+                  << " nonce=" << ack.nonce << (ack.status == TxAck::Status::Timeout ? " timeout" : " rejected")
+                  << " code=" << ack.code << " after " << ack.latencyUs << " us: " << ack.message << std::endl;
+        // отказ или потеря оставляют дыру в nonce ключа — менеджер сверит его с сервером в фоне
+        if (_nonces) _nonces->onFailed(lease, ack.status == TxAck::Status::Timeout ? "timeout" : ack.message);
+    };
+    _txAcks = std::make_unique<TxAckTracker>(acfg);
+
     LighterTxWS::Config cfg;
     cfg.url = wssUrl;
     cfg.extraHeaders = headers;
-    cfg.onMessage = [](const std::string &msg) {
-        // Логируем все ответы от сокета Lighter
+    cfg.onMessage = [this](std::string_view msg) {
+        if (_txAcks->onMessage(msg)) return;
+        // Остальное (ping, служебные и чужие ответы) логируем как раньше
         std::cout << "[LighterTxWS][recv] " << msg << std::endl;
     };
     _txWs = std::make_unique<LighterTxWS>(cfg);
     _txWs->start();
 }
 
-std::string LighterRequests::sendTxOverWs(int txType, const std::string &txInfoJson) {
-    ensureTxWs();
+std::string LighterRequests::nextTxId() {
+    // id — ключ таблицы ожидающих ответа, счётчик исключает совпадения при отправке в один такт часов
     std::ostringstream id;
-    id << "mm_" << std::chrono::steady_clock::now().time_since_epoch().count();
+    id << "mm_" << std::chrono::steady_clock::now().time_since_epoch().count() << "_" << _txSeq.fetch_add(1);
+    return id.str();
+}
+
+void LighterRequests::sendTxOverWs(const std::string &id, int txType, const std::string &txInfoJson,
+                                   const NonceLease &lease, TxAckTracker::Callback &&onAck) {
+    ensureTxWs();
     std::ostringstream os;
-    os << "{\"type\":\"jsonapi/sendtx\",\"data\":{\"id\":\"" << id.str() <<
+    os << "{\"type\":\"jsonapi/sendtx\",\"data\":{\"id\":\"" << id <<
             "\",\"tx_type\":" << txType << ",\"tx_info\":" << txInfoJson << "}}";
+    _txAcks->track(id, txType, lease.apiKeyIndex, lease.nonce, std::move(onAck));
     _txWs->sendText(os.str());
-    return id.str();
+}
+
+TxAckTracker::Stats LighterRequests::txAckStats() const {
+    return _txAcks ? _txAcks->stats() : TxAckTracker::Stats{};
 }
 
 std::string LighterRequests::createOrder(
@@ -249,19 +380,7 @@ std::string LighterRequests::createOrder(
     const std::string &type,
     std::string quantity,
     const std::optional<double> &price) {
-    (void) symbol;
-    (void) side;
     (void) type;
-    (void) quantity;
-    (void) price;
-    // Сделал для себя заглушку под виндовс, можно даже и не удалять
-    bool signerReady = false;
-    if (!_signer.has_value()) _signer = LighterSigner(_signerDllPath.value());
-    if (auto err = _signer->createClient(_baseUrl, _apiKeyPrivate.value(), _chainId, _apiKeyIndex, _accountIndex); !
-        err) {
-        signerReady = true;
-    }
-
     // В лайтере нельзя передавать float, поэтому тут математика со скейлом будет в ридми
     long long baseAmountInt = 0;
     double qtyBase = 0.0;
@@ -276,29 +395,15 @@ std::string LighterRequests::createOrder(
     if (_priceScale <= 0) {
         throw std::runtime_error("priceScale не задан (<= 0)");
     }
-    // мб придется раскоментить
-    // double acceptablePriceFloat = 1.5;
-    // if (price.has_value()) {
-    //     acceptablePriceFloat = price.value();
-    // } else {
-    //     // Получим стакан и посчитаем среднюю цену исполнения для указанного объёма
-    //     const int depthLimit = 50;
-    //     MarketDepth depth = fetchMarketDepth(symbol, depthLimit);
-    //     float avgExec = 0.0f;
-    //     if (side == "SELL") {
-    //         // Продаём в бид — усреднённая цена для объёма
-    //         avgExec = depth.GetBestBidPriceFor((float) qtyBase);
-    //         if (avgExec <= 0.0f) throw std::runtime_error("Недостаточно ликвидности в стакане для SELL объёма");
-    //         acceptablePriceFloat = (double) avgExec * (1.0 - _defaultSlippage);
-    //     } else {
-    //         // Покупаем из аск — усреднённая цена для объёма
-    //         avgExec = depth.GetBestAskPriceFor((float) qtyBase);
-    //         if (avgExec <= 0.0f) throw std::runtime_error("Недостаточно ликвидности в стакане для BUY объёма");
-    //         acceptablePriceFloat = (double) avgExec * (1.0 + _defaultSlippage);
-    //     }
-    // }
-
     int acceptablePriceInt = this->getAcceptablePriceInt(price, symbol, qtyBase, side);
+    return createOrderScaled(side, baseAmountInt, acceptablePriceInt);
+}
+
+std::string LighterRequests::signCreateOrderTx(bool isAsk, long long baseAmountInt, int priceArg,
+                                               const NonceLease &lease) {
+    // Сделал для себя заглушку под виндовс, можно даже и не удалять
+    if (!signerReady()) return "dummy";
+
     // ----------------
     // кастомное шифрование лайтар, работает - не трогаем
     constexpr long long CLIENT_ORDER_INDEX_MAX = ((1LL << 48) - 1);
@@ -307,70 +412,52 @@ std::string LighterRequests::createOrder(
     const long long clientOrderIndex = (nowMicros % CLIENT_ORDER_INDEX_MAX);
     // ----------------
 
-    int isAsk = (side == "SELL" ? 1 : 0);
-    const int orderType = 0; // LIMIT
-    const int tif = 1; // good till date - для лимиток самое то
+    const int orderType = ORDER_TYPE_LIMIT;
+    const int tif = ORDER_TIME_IN_FORCE_GOOD_TILL_TIME; // good till date - для лимиток самое то
     const int reduceOnly = 0;
-    const int trigger = 0;
-    const long long expiry = -1; // вроде = никогда, todo expire = deadline
-    const long long nonce = acquireNextNonce();
+    const int trigger = NIL_TRIGGER_PRICE;
+    const long long expiry = DEFAULT_28_DAY_ORDER_EXPIRY; // todo expire = deadline
     // подпись сделки
-    std::string signedPayload;
-    if (signerReady) {
-        auto signedRes = _signer->signCreateOrder(_marketIndex, clientOrderIndex, baseAmountInt, acceptablePriceInt,
-                                                  isAsk, orderType, tif, reduceOnly, trigger, expiry, nonce);
-        if (signedRes.second) throw std::runtime_error("LighterSigner signCreateOrder error: " + *signedRes.second);
-        signedPayload = *signedRes.first;
-    } else {
-        // Заглушка для винды
-        signedPayload = "dummy";
-    }
-    std::vector<std::string> headers;
-    const std::string token = _authToken ? _authToken.value() : std::string(std::getenv("LIGHTER_AUTH_TOKEN"));
-    headers.emplace_back(std::string("Authorization: Bearer ") + token);
-    headers.emplace_back("Content-Type: application/x-www-form-urlencoded");
+    auto signedRes = _signer->signCreateOrder(lease.apiKeyIndex, _marketIndex, clientOrderIndex, baseAmountInt, priceArg,
+                                              isAsk ? 1 : 0, orderType, tif, reduceOnly, trigger, expiry, lease.nonce);
+    if (signedRes.second) throw std::runtime_error("LighterSigner signCreateOrder error: " + *signedRes.second);
+    return *signedRes.first;
+}
 
-    // application/x-www-form-urlencoded: tx_type=14&price_protection=true&tx_info=<percent-encoded> по доке
-    auto isUnreserved = [](unsigned char c) -> bool {
-        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c
-               == '.' || c == '~';
-    };
-    // работает не трогаем, опять же легче написано в их sdk на питоне
-    //TODO: ну это не используется, скорее всего убрать надо
-    auto percentEncode = [&](const std::string &s) -> std::string {
-        static const char *hex = "0123456789ABCDEF";
-        std::string out;
-        out.reserve(s.size() * 3);
-        for (unsigned char c: s) {
-            if (isUnreserved(c)) out.push_back((char) c);
-            else {
-                out.push_back('%');
-                out.push_back(hex[(c >> 4) & 0xF]);
-                out.push_back(hex[c & 0xF]);
-            }
-        }
-        return out;
-    };
+std::string LighterRequests::signModifyOrderTx(long long orderIndex, long long baseAmountInt, int priceArg,
+                                               const NonceLease &lease) {
+    // Сделал для себя заглушку под виндовс, можно даже и не удалять
+    if (!signerReady()) return "dummy";
+    const int trigger = NIL_TRIGGER_PRICE;
+    auto signedRes = _signer->signModifyOrder(lease.apiKeyIndex, _marketIndex, orderIndex, baseAmountInt, priceArg,
+                                              trigger, lease.nonce);
+    if (signedRes.second) throw std::runtime_error("LighterSigner signModifyOrder error: " + *signedRes.second);
+    return *signedRes.first;
+}
 
+std::string LighterRequests::createOrderScaled(const std::string &side, long long baseAmountInt, long long priceInt,
+                                              TxAckTracker::Callback onAck) {
+    const int priceArg = checkedPriceInt(priceInt);
+    scheduler().charge(); // синхронный путь мимо очереди, но в общем бюджете
+    const NonceLease lease = nonces().acquire();
+    std::string signedPayload;
+    try {
+        signedPayload = signCreateOrderTx(side == "SELL", baseAmountInt, priceArg, lease);
+    } catch (const std::exception &ex) {
+        nonces().onFailed(lease, ex.what());
+        throw;
+    }
     // Быстрая отправка по WS
-    sendTxOverWs(TX_TYPE_CREATE_ORDER, signedPayload);
-    return std::string("sent-via-ws");
+    const std::string id = nextTxId();
+    sendTxOverWs(id, TX_TYPE_CREATE_ORDER, signedPayload, lease, std::move(onAck));
+    return id;
 }
 
 //todo тут и в httpclient теряется скорость, надо подумать как отправлять максимально быстрые запросы
 std::string LighterRequests::modifyOrder(const std::string &symbol,
                                          const std::string &quantity, const std::optional<double> &price,
                                          long long orderIndex, std::string &side, bool hasGoodSpread) {
-    (void) symbol;
-    (void) quantity;
-    (void) price;
-    // Сделал для себя заглушку под виндовс, можно даже и не удалять
-    bool signerReady = true;
-    // if (!_signer.has_value()) _signer = LighterSigner(_signerDllPath.value());
-    // if (auto err = _signer->createClient(_baseUrl, _apiKeyPrivate.value(), _chainId, _apiKeyIndex, _accountIndex); !
-    //     err) {
-    //     signerReady = true;
-    // }
+    (void) hasGoodSpread;
     // В лайтере нельзя передавать float, поэтому тут математика со скейлом будет в ридми
     long long baseAmountInt = 0;
     double qtyBase = 0.0;
@@ -386,63 +473,361 @@ std::string LighterRequests::modifyOrder(const std::string &symbol,
         throw std::runtime_error("priceScale не задан (<= 0)");
     }
     int acceptablePriceInt = this->getAcceptablePriceInt(price, symbol, qtyBase, side);
+    return modifyOrderScaled(orderIndex, baseAmountInt, acceptablePriceInt);
+}
 
-    const int trigger = 0;
-    const long long nonce = acquireNextNonce();
-    // подпись сделки
+std::string LighterRequests::modifyOrderScaled(long long orderIndex, long long baseAmountInt, long long priceInt,
+                                              TxAckTracker::Callback onAck) {
+    const int priceArg = checkedPriceInt(priceInt);
+    scheduler().charge();
+    const NonceLease lease = nonces().acquire();
     std::string signedPayload;
-    if (signerReady) {
-        auto signedRes = _signer->signModifyOrder(_marketIndex, orderIndex, baseAmountInt, acceptablePriceInt,
-                                                  trigger, nonce);
-        if (signedRes.second) throw std::runtime_error("LighterSigner signModifyOrder error: " + *signedRes.second);
-        signedPayload = *signedRes.first;
-    } else {
-        // Заглушка для винды
-        signedPayload = "dummy";
+    try {
+        signedPayload = signModifyOrderTx(orderIndex, baseAmountInt, priceArg, lease);
+    } catch (const std::exception &ex) {
+        nonces().onFailed(lease, ex.what());
+        throw;
     }
-    std::vector<std::string> headers;
-    const std::string token = _authToken ? _authToken.value() : std::string(std::getenv("LIGHTER_AUTH_TOKEN"));
-    headers.emplace_back(std::string("Authorization: Bearer ") + token);
-    headers.emplace_back("Content-Type: application/x-www-form-urlencoded");
+    // Быстрая отправка по WS
+    const std::string id = nextTxId();
+    sendTxOverWs(id, TX_TYPE_MODIFY_ORDER, signedPayload, lease, std::move(onAck));
+    return id;
+}
 
-    // application/x-www-form-urlencoded: tx_type=14&price_protection=true&tx_info=<percent-encoded> по доке
-    auto isUnreserved = [](unsigned char c) -> bool {
-        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c
-               == '.' || c == '~';
+OrderPipeline &LighterRequests::pipeline() {
+    std::call_once(_pipelineOnce, [this]() {
+        OrderPipeline::Config pcfg;
+        pcfg.workers = _signWorkers;
+        pcfg.acquireNonce = [this]() { return nonces().acquire(); };
+        pcfg.send = [this](const std::string &id, int txType, const std::string &payload, const NonceLease &lease,
+                           TxAckTracker::Callback &&onAck) {
+            sendTxOverWs(id, txType, payload, lease, std::move(onAck));
+        };
+        pcfg.onSignError = [this](const NonceLease &lease, const std::string &error) {
+            // сгоревший nonce: всё, что за ним, сервер отклонит — ключ уходит на сверку
+            nonces().onFailed(lease, error);
+        };
+        _pipeline = std::make_unique<OrderPipeline>(pcfg);
+    });
+    return *_pipeline;
+}
+
+void LighterRequests::enablePresign(int windowTicks) {
+    if (!_nonces) {
+        std::cerr << "[LighterRequests] presign needs setSignerConfig first, disabled" << std::endl;
+        return;
+    }
+    // Лестнице — свой ключ вне круга: с общим ключом любая транзакция сдвигала nonce и сбрасывала
+    // всю лестницу раньше, чем ей успевали воспользоваться, а подпись окна стоила CPU на каждую tx
+    const std::vector<int> keys = _signer->apiKeyIndices();
+    const int presignKey = keys.back();
+    if (keys.size() < 2 || !_nonces->reserve(presignKey)) {
+        std::cerr << "[LighterRequests] presign needs a dedicated api key (LIGHTER_EXTRA_API_KEYS), disabled" << std::endl;
+        return;
+    }
+    std::cout << "[LighterRequests] presign uses api key " << presignKey << std::endl;
+    PresignedLadder::Config lcfg;
+    lcfg.windowTicks = windowTicks;
+    lcfg.createTxType = TX_TYPE_CREATE_ORDER;
+    lcfg.modifyTxType = TX_TYPE_MODIFY_ORDER;
+    lcfg.peekNonce = [this, presignKey]() { return _nonces->peek(presignKey); };
+    lcfg.sign = [this](const PresignedLadder::Key &k, const NonceLease &lease) {
+        // заглушку "dummy" лестнице не отдаём: запись выглядела бы годной и сожгла бы nonce на бирже
+        if (!signerReady()) throw std::runtime_error("signer not ready");
+        const int priceArg = checkedPriceInt(k.price);
+        if (k.txType == TX_TYPE_MODIFY_ORDER) return signModifyOrderTx(k.orderIndex, k.baseAmount, priceArg, lease);
+        return signCreateOrderTx(k.isAsk, k.baseAmount, priceArg, lease);
     };
-    // работает не трогаем, опять же легче написано в их sdk на питоне
-    //TODO: ну это не используется, скорее всего убрать надо
-    auto percentEncode = [&](const std::string &s) -> std::string {
-        static const char *hex = "0123456789ABCDEF";
-        std::string out;
-        out.reserve(s.size() * 3);
-        for (unsigned char c: s) {
-            if (isUnreserved(c)) out.push_back((char) c);
-            else {
-                out.push_back('%');
-                out.push_back(hex[(c >> 4) & 0xF]);
-                out.push_back(hex[c & 0xF]);
-            }
-        }
-        return out;
+    // второй ключ включает у signer переключение ключей под исключительным локом: подпись лестницы
+    // задержала бы подпись живой транзакции, поэтому лестница подписывает только при пустом конвейере
+    // конвейер создаём здесь: поток лестницы не должен создавать его сам, гоняясь с деструктором
+    OrderPipeline &orders = pipeline();
+    lcfg.canSign = [&orders]() { return orders.idle(); };
+    _ladder = std::make_unique<PresignedLadder>(lcfg);
+    // предподписанное под выданный (или сверенный) nonce больше не отправить; прочие ключи лестницу не трогают
+    _nonces->setOnChanged([this, presignKey](int apiKeyIndex) {
+        if (apiKeyIndex == presignKey) _ladder->onNonceChanged();
+    });
+}
+
+void LighterRequests::presignBook(long long bidTicks, long long askTicks, long long tickTicks, long long createBaseAmount) {
+    if (_ladder) _ladder->setBook(bidTicks, askTicks, tickTicks, createBaseAmount);
+}
+
+void LighterRequests::presignModifyTarget(long long orderIndex, bool isAsk, long long baseAmount) {
+    if (_ladder) _ladder->setModifyTarget(orderIndex, isAsk, baseAmount);
+}
+
+PresignedLadder::Stats LighterRequests::presignStats() const {
+    return _ladder ? _ladder->stats() : PresignedLadder::Stats{};
+}
+
+bool LighterRequests::trySendPresigned(std::initializer_list<PresignedLadder::Key> keys, const std::string &id,
+                                       TxAckTracker::Callback &onAck) {
+    if (!_ladder) return false;
+    auto e = _ladder->find(keys);
+    if (!e) return false;
+    // nonce ключа лестницы выдаёт только takeIf, а выдача и отправка идут под _presignSendMtx:
+    // предыдущий nonce этого ключа уже отправлен, следующий не может его обогнать. Лок nonce на время
+    // отправки не держим — acquire() остальных ключей не ждёт сокет
+    std::lock_guard<std::mutex> lk(_presignSendMtx);
+    if (!_nonces->takeIf(e->lease)) {
+        _ladder->noteStale();
+        return false;
+    }
+    try {
+        sendTxOverWs(id, e->key.txType, e->payload, e->lease, TxAckTracker::Callback(onAck));
+    } catch (const std::exception &ex) {
+        // nonce выдан, но не ушёл: ключ лестницы — на сверку (onChanged сбросит лестницу),
+        // а транзакция — в обычный конвейер с нетронутым onAck
+        std::cerr << "[LighterRequests] presigned send failed: " << ex.what() << std::endl;
+        _nonces->onFailed(e->lease, ex.what());
+        return false;
+    }
+    _ladder->noteHit();
+    return true;
+}
+
+std::string LighterRequests::submitCreateOrder(const std::string &side, long long baseAmountInt, long long priceInt,
+                                               TxAckTracker::Callback onAck) {
+    checkedPriceInt(priceInt); // ошибка цены — сразу вызывающему, а не в отложенной отправке
+    const bool isAsk = side == "SELL";
+    const std::string id = nextTxId();
+    schedule(TxScheduler::Priority::Create, id, TX_TYPE_CREATE_ORDER, std::move(onAck),
+             [this, id, isAsk, baseAmountInt, priceInt](TxAckTracker::Callback ack) {
+                 dispatchCreateOrder(id, isAsk, baseAmountInt, priceInt, std::move(ack));
+             });
+    return id;
+}
+
+void LighterRequests::dispatchCreateOrder(const std::string &id, bool isAsk, long long baseAmountInt,
+                                          long long priceInt, TxAckTracker::Callback onAck) {
+    const int priceArg = checkedPriceInt(priceInt);
+    if (trySendPresigned({{TX_TYPE_CREATE_ORDER, isAsk, 0, baseAmountInt, priceInt}}, id, onAck)) return;
+    pipeline().submit(id, TX_TYPE_CREATE_ORDER, [this, isAsk, baseAmountInt, priceArg](const NonceLease &lease) {
+        return signCreateOrderTx(isAsk, baseAmountInt, priceArg, lease);
+    }, std::move(onAck));
+}
+
+void LighterRequests::schedule(TxScheduler::Priority priority, const std::string &id, int txType,
+                               TxAckTracker::Callback onAck, std::function<void(TxAckTracker::Callback)> dispatch) {
+    auto fail = [id, txType, onAck](const std::string &error) {
+        // отложенная отправка не состоялась (например, nonce на сверке) — владелец узнаёт через onAck
+        if (!onAck) return;
+        TxAck ack;
+        ack.status = TxAck::Status::Rejected;
+        ack.id = id;
+        ack.txType = txType;
+        ack.message = error;
+        onAck(ack);
     };
+    if (_stopping.load()) {
+        fail("scheduler stopped");
+        return;
+    }
+    scheduler().submit(priority, [dispatch, onAck]() { dispatch(onAck); }, std::move(fail));
+}
 
-    // Быстрая отправка по WS
-    sendTxOverWs(TX_TYPE_MODIFY_ORDER, signedPayload);
-    return std::string("sent-via-ws");
+TxScheduler &LighterRequests::scheduler() {
+    std::call_once(_schedulerOnce, [this]() {
+        TxScheduler::Config scfg;
+        scfg.ratePerSec = _txRatePerSec;
+        scfg.burst = _txBurst;
+        _scheduler = std::make_unique<TxScheduler>(scfg);
+    });
+    return *_scheduler;
+}
+
+void LighterRequests::setTxRateLimit(double ratePerSec, double burst) {
+    _txRatePerSec = ratePerSec;
+    _txBurst = burst;
+}
+
+TxScheduler::Budget LighterRequests::txBudget() {
+    return scheduler().budget();
+}
+
+TxScheduler::Stats LighterRequests::txSchedulerStats() const {
+    return _scheduler ? _scheduler->stats() : TxScheduler::Stats{};
+}
+
+std::string LighterRequests::submitModifyOrder(long long orderIndex, long long baseAmountInt, long long priceInt,
+                                               TxAckTracker::Callback onAck) {
+    checkedPriceInt(priceInt); // ошибка цены — сразу вызывающему, а не в отложенной отправке
+    const std::string id = nextTxId();
+    _modifyCoalescer->submit(id, orderIndex, {baseAmountInt, priceInt}, std::move(onAck));
+    return id;
+}
+
+void LighterRequests::dispatchModifyOrder(const std::string &id, long long orderIndex, long long baseAmountInt,
+                                          long long priceInt, TxAckTracker::Callback onAck) {
+    const int priceArg = checkedPriceInt(priceInt);
+    // isAsk в ключе modify — сторона, под которую лестница подписывала этот orderIndex; она неизвестна,
+    // поэтому одним поиском под обе — промах считается один раз
+    if (trySendPresigned({{TX_TYPE_MODIFY_ORDER, false, orderIndex, baseAmountInt, priceInt},
+                          {TX_TYPE_MODIFY_ORDER, true, orderIndex, baseAmountInt, priceInt}}, id, onAck)) {
+        return;
+    }
+    pipeline().submit(id, TX_TYPE_MODIFY_ORDER, [this, orderIndex, baseAmountInt, priceArg](const NonceLease &lease) {
+        return signModifyOrderTx(orderIndex, baseAmountInt, priceArg, lease);
+    }, std::move(onAck));
+}
+
+OrderPipeline::Stats LighterRequests::pipelineStats() const {
+    return _pipeline ? _pipeline->stats() : OrderPipeline::Stats{};
+}
+
+ModifyCoalescer::Stats LighterRequests::modifyCoalescerStats() const {
+    return _modifyCoalescer->stats();
+}
+
+int LighterRequests::checkedPriceInt(long long priceInt) {
+    // signer принимает цену как int32
+    if (priceInt <= 0 || priceInt > std::numeric_limits<int>::max()) {
+        throw std::runtime_error("price вне диапазона signer'а: " + std::to_string(priceInt));
+    }
+    return static_cast<int>(priceInt);
 }
 
 bool LighterRequests::cancelOrder(const std::string &symbol, const std::string &orderId) {
-    (void) symbol;
-    (void) orderId;
-    // todo если expire = deadline, то не понадобиться
+    (void) symbol; // рынок — _marketIndex
+    char *end = nullptr;
+    const long long orderIndex = std::strtoll(orderId.c_str(), &end, 10);
+    if (orderId.empty() || *end != '\0' || orderIndex <= 0) {
+        std::cerr << "[LighterRequests] cancelOrder: bad order index '" << orderId << "'" << std::endl;
+        return false;
+    }
+    try {
+        submitCancelOrder(orderIndex);
+    } catch (const std::exception &ex) {
+        std::cerr << "[LighterRequests] cancelOrder failed: " << ex.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string LighterRequests::submitCancelOrder(long long orderIndex, TxAckTracker::Callback onAck) {
+    const std::string id = nextTxId();
+    schedule(TxScheduler::Priority::Cancel, id, TX_TYPE_CANCEL_ORDER, std::move(onAck),
+             [this, id, orderIndex](TxAckTracker::Callback ack) {
+        pipeline().submit(id, TX_TYPE_CANCEL_ORDER, [this, orderIndex](const NonceLease &lease) -> std::string {
+            // заглушка ушла бы на биржу отменой, которая ничего не отменяет; исключение конвейер вернёт как Rejected
+            if (!signerReady()) throw std::runtime_error("signer not ready");
+            auto signedRes = _signer->signCancelOrder(lease.apiKeyIndex, _marketIndex, orderIndex, lease.nonce);
+            if (signedRes.second) throw std::runtime_error("LighterSigner signCancelOrder error: " + *signedRes.second);
+            return *signedRes.first;
+        }, std::move(ack));
+    });
+    return id;
+}
+
+std::string LighterRequests::submitCancelAll(int timeInForce, long long time, TxAckTracker::Callback onAck) {
+    const std::string id = nextTxId();
+    schedule(TxScheduler::Priority::Cancel, id, TX_TYPE_CANCEL_ALL_ORDERS, std::move(onAck),
+             [this, id, timeInForce, time](TxAckTracker::Callback ack) {
+        pipeline().submit(id, TX_TYPE_CANCEL_ALL_ORDERS, [this, timeInForce, time](const NonceLease &lease) {
+            return signCancelAllTx(timeInForce, time, lease);
+        }, std::move(ack));
+    });
+    return id;
+}
+
+std::string LighterRequests::signCancelAllTx(int timeInForce, long long time, const NonceLease &lease) {
+    // без signer — ошибка, не заглушка: продление dead-man switch и cancelAllOrders должны увидеть отказ
+    if (!signerReady()) throw std::runtime_error("signer not ready");
+    auto signedRes = _signer->signCancelAllOrders(lease.apiKeyIndex, timeInForce, time, lease.nonce);
+    if (signedRes.second) throw std::runtime_error("LighterSigner signCancelAllOrders error: " + *signedRes.second);
+    return *signedRes.first;
+}
+
+std::string LighterRequests::submitCancelAllOrders(TxAckTracker::Callback onAck) {
+    return submitCancelAll(CANCEL_ALL_TIF_IMMEDIATE, 0, std::move(onAck));
+}
+
+bool LighterRequests::cancelAllOrders(int timeoutMs) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::string lastError = "timeout";
+    while (std::chrono::steady_clock::now() < deadline) {
+        auto result = std::make_shared<std::promise<TxAck>>();
+        auto answered = std::make_shared<std::atomic<bool>>(false);
+        std::future<TxAck> ackFuture = result->get_future();
+        try {
+            // до выдачи nonce: иначе каждая попытка без signer отправляла бы ключ на сверку
+            if (!signerReady()) throw std::runtime_error("signer not ready");
+            scheduler().charge(); // как createOrderScaled: мимо очереди, но в общем бюджете
+            const NonceLease lease = nonces().acquire();
+            std::string signedPayload;
+            try {
+                signedPayload = signCancelAllTx(CANCEL_ALL_TIF_IMMEDIATE, 0, lease);
+            } catch (const std::exception &ex) {
+                nonces().onFailed(lease, ex.what());
+                throw;
+            }
+            sendTxOverWs(nextTxId(), TX_TYPE_CANCEL_ALL_ORDERS, signedPayload, lease, [result, answered](const TxAck &ack) {
+                if (!answered->exchange(true)) result->set_value(ack);
+            });
+        } catch (const std::exception &ex) {
+            // ключ на сверке или сбой подписи — пробуем снова, пока есть время
+            lastError = ex.what();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
+        }
+        if (ackFuture.wait_until(deadline) != std::future_status::ready) break;
+        const TxAck ack = ackFuture.get();
+        if (ack.status == TxAck::Status::Accepted) return true;
+        lastError = ack.message;
+        // nonce обогнал транзакцию из конвейера — ключ сверится, следующая попытка возьмёт верный
+        if (ack.status != TxAck::Status::NonceError && ack.status != TxAck::Status::RateLimited) break;
+    }
+    std::cerr << "[LighterRequests] cancel-all failed: " << lastError << std::endl;
     return false;
 }
 
+void LighterRequests::startCancelAllHeartbeat(int windowMs, int renewMs, std::function<bool()> healthy,
+                                              std::function<void()> onGaveUp) {
+    if (_cancelAllHeartbeat) _cancelAllHeartbeat->stop();
+    CancelAllHeartbeat::Config hcfg;
+    hcfg.windowMs = windowMs;
+    hcfg.renewMs = renewMs;
+    hcfg.healthy = std::move(healthy);
+    hcfg.onGaveUp = std::move(onGaveUp);
+    hcfg.renew = [this](long long atEpochMs, std::function<void(bool)> done) {
+        // каждое продление переносит уже запланированный cancel-all на новый срок
+        submitCancelAll(CANCEL_ALL_TIF_SCHEDULED, atEpochMs, [done = std::move(done)](const TxAck &ack) {
+            done(ack.status == TxAck::Status::Accepted);
+        });
+    };
+    _cancelAllHeartbeat = std::make_unique<CancelAllHeartbeat>(hcfg);
+    _cancelAllHeartbeat->start();
+}
+
+void LighterRequests::stopCancelAllHeartbeat() {
+    if (_cancelAllHeartbeat) _cancelAllHeartbeat->stop();
+}
+
+CancelAllHeartbeat::Stats LighterRequests::cancelAllHeartbeatStats() const {
+    return _cancelAllHeartbeat ? _cancelAllHeartbeat->stats() : CancelAllHeartbeat::Stats{};
+}
+
+
+static const char *kChangeAccountTierPath = "/api/v1/changeAccountTier";
 
 std::string LighterRequests::changeAccountTier(long long accountIndex, const std::string &newTier) {
-    std::string path = "/api/v1/changeAccountTier";
+    std::string body;
+    std::vector<std::string> headers;
+    buildChangeAccountTier(accountIndex, newTier, body, headers);
+    return HttpClient::httpPost(_baseUrl, kChangeAccountTierPath, body, headers);
+}
 
+std::future<std::string> LighterRequests::changeAccountTierAsync(long long accountIndex, const std::string &newTier) {
+    std::string body;
+    std::vector<std::string> headers;
+    buildChangeAccountTier(accountIndex, newTier, body, headers);
+    return HttpClient::httpPostAsync(_baseUrl, kChangeAccountTierPath, body, headers);
+}
+
+void LighterRequests::buildChangeAccountTier(long long accountIndex, const std::string &newTier,
+                                             std::string &bodyOut, std::vector<std::string> &headers) {
     // form-urlencoded
     auto isUnreserved = [](unsigned char c) -> bool {
         return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c
@@ -465,7 +850,7 @@ std::string LighterRequests::changeAccountTier(long long accountIndex, const std
 
     // Получаем актуальный auth токен: если доступен signer — сгенерируем свежий с дедлайном
     std::string token;
-    if (_signer.has_value()) {
+    if (_signer) {
         long long deadline = (long long) std::chrono::duration_cast<std::chrono::seconds>(
                                  std::chrono::system_clock::now().time_since_epoch()).count() + 600; // +10 минут
         auto t = _signer->createAuthToken(deadline);
@@ -485,10 +870,8 @@ std::string LighterRequests::changeAccountTier(long long accountIndex, const std
         body << "&auth=" << percentEncode(token);
     }
 
-    std::vector<std::string> headers;
+    bodyOut = body.str();
     if (!token.empty()) headers.emplace_back(std::string("Authorization: Bearer ") + token);
     headers.emplace_back("Content-Type: application/x-www-form-urlencoded");
     headers.emplace_back("Accept: application/json");
-
-    return HttpClient::httpPost(_baseUrl, path, body.str(), headers);
 }
@@ -3,16 +3,28 @@
 #include <string>
 #include <optional>
 #include <mutex>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <future>
 #include "../Requests.h"
 #include "../http/HttpClient.h"
-#include "LighterSigner.h"
+#include "SignerSession.h"
 #include "LighterTxWS.h"
+#include "TxAckTracker.h"
+#include "OrderPipeline.h"
+#include "PresignedLadder.h"
+#include "NonceManager.h"
+#include "CancelAllHeartbeat.h"
+#include "ModifyCoalescer.h"
+#include "TxScheduler.h"
 
 // Интеграция Lighter API: стакан (OrderApi.orderBookDetails/orderBookOrders)
 // и отправка подписанной транзакции (TransactionApi.sendTx) для маркет-ордера.
 class LighterRequests : public Requests, protected HttpClient {
 public:
     LighterRequests();
+    ~LighterRequests() override;
     explicit LighterRequests(const std::string &baseUrl);
 
     void setBaseUrl(const std::string &url) override;
@@ -38,6 +50,23 @@ public:
             long long baseAmountScale,
             int priceScale
     );
+    // То же с несколькими api key одного аккаунта: у каждого свой nonce, транзакции раздаются по кругу
+    void setSignerConfig(
+            const std::string &dllPath,
+            const std::vector<SignerSession::ApiKey> &apiKeys,
+            int chainId,
+            long long accountIndex,
+            long long baseAmountScale,
+            int priceScale
+    );
+
+    // Время подписи, пересоздания клиента и ошибки signer'а
+    SignerSession::Stats signerStats() const;
+    // Выданные/подтверждённые nonce, сверки с сервером — по каждому ключу
+    NonceManager::Stats nonceStats() const;
+
+    long long getBaseAmountScale() const { return _baseAmountScale; }
+    long long getPriceScale() const { return _priceScale; }
 
     // Рыночный индекс и дефолтный слиппедж для защиты цены
     void setMarketIndex(int marketIndex);
@@ -46,6 +75,8 @@ public:
     // Public market data
     MarketDepth fetchMarketDepth(const std::string &symbol, int limit) override;
     std::string fetchMarketDepthRaw(const std::string &symbol, int limit) override;
+    // Без блокировки: независимые REST-запросы (стакан, tier, nonce) летят параллельно
+    std::future<MarketDepth> fetchMarketDepthAsync(const std::string &symbol, int limit);
 
     // Trading (MARKET) — отправляет /sendTx с tx_type=14
     std::string createOrder(
@@ -65,13 +96,71 @@ public:
         bool hasGoodSpread
     ) ;
 
+    // То же в целых (лоты/тики по скейлам signer'а) — без float-округлений перед подписью.
+    // Возвращают id запроса sendtx; onAck придёт из потока NetLoop с ответом сервера или по таймауту
+    std::string createOrderScaled(const std::string &side, long long baseAmountInt, long long priceInt,
+                                  TxAckTracker::Callback onAck = {});
+    std::string modifyOrderScaled(long long orderIndex, long long baseAmountInt, long long priceInt,
+                                  TxAckTracker::Callback onAck = {});
+
+    // То же асинхронно: nonce берётся сразу, подпись — в пуле потоков, отправка — в порядке nonce.
+    // Возвращают id запроса, не дожидаясь подписи; ошибка подписи придёт в onAck как Rejected
+    std::string submitCreateOrder(const std::string &side, long long baseAmountInt, long long priceInt,
+                                  TxAckTracker::Callback onAck = {});
+    // modify ордера, у которого предыдущий modify ещё ждёт ответа, откладывается; более новая цель
+    // заменяет отложенную, и onAck заменённой получает Superseded
+    std::string submitModifyOrder(long long orderIndex, long long baseAmountInt, long long priceInt,
+                                  TxAckTracker::Callback onAck = {});
+    // Потоков подписи (до первого submit*)
+    void setSignWorkers(int n) { _signWorkers = n; }
+    OrderPipeline::Stats pipelineStats() const;
+    // Лимит частоты транзакций (до первого submit*): все submit* проходят token bucket,
+    // без токена ждут в очереди с приоритетом cancel > modify > create
+    void setTxRateLimit(double ratePerSec, double burst);
+    // Сколько транзакций можно отправить прямо сейчас и выученная скорость
+    TxScheduler::Budget txBudget();
+    TxScheduler::Stats txSchedulerStats() const;
+    // submitModifyOrder держит на ордер один modify в полёте; сколько целей схлопнуто, пока ждали
+    ModifyCoalescer::Stats modifyCoalescerStats() const;
+
+    // Предподпись: create/modify на windowTicks тиков вокруг лучших цен подписываются заранее,
+    // submit* на такую цену и объём уходит сразу, без подписи. Включать до начала торговли
+    void enablePresign(int windowTicks);
+    // Центр лестницы — из потока стратегии на каждом обновлении книги
+    void presignBook(long long bidTicks, long long askTicks, long long tickTicks, long long createBaseAmount);
+    // Активный ордер для предподписи modify; orderIndex == 0 — снять
+    void presignModifyTarget(long long orderIndex, bool isAsk, long long baseAmount);
+    PresignedLadder::Stats presignStats() const;
+
+    // orderId — order_index ордера; отмена уходит асинхронно, true — поставлена в очередь
     bool cancelOrder(
             const std::string &symbol,
             const std::string &orderId
     ) override;
 
+    // Отмена одного ордера / всех ордеров аккаунта сразу; возвращают id запроса sendtx
+    std::string submitCancelOrder(long long orderIndex, TxAckTracker::Callback onAck = {});
+    std::string submitCancelAllOrders(TxAckTracker::Callback onAck = {});
+    // Снять все ордера синхронно, мимо очереди лимита и конвейера (их может уже не быть — остановка):
+    // подпись и отправка в этом потоке, ждём ответа биржи не дольше timeoutMs, отказ по nonce — повторяем.
+    // true — биржа приняла
+    bool cancelAllOrders(int timeoutMs);
+    // Dead-man switch: биржа снимет все ордера через windowMs, если перестанем продлевать
+    // (падение, зависание, healthy() == false). Продление каждые renewMs; onGaveUp — продления
+    // подряд отклоняются и остановлены, ордера больше не защищены (поток NetLoop)
+    void startCancelAllHeartbeat(int windowMs, int renewMs, std::function<bool()> healthy = {},
+                                 std::function<void()> onGaveUp = {});
+    void stopCancelAllHeartbeat();
+    CancelAllHeartbeat::Stats cancelAllHeartbeatStats() const;
+
     // Change account tier via REST
     std::string changeAccountTier(long long accountIndex, const std::string &newTier);
+    std::future<std::string> changeAccountTierAsync(long long accountIndex, const std::string &newTier);
+
+    // Сколько ждать ответа на sendtx, прежде чем считать его потерянным (до первой отправки)
+    void setTxAckTimeoutMs(int ms) { _txAckTimeoutMs = ms; }
+    // Принятые/отклонённые/потерянные транзакции и задержка отправка -> ответ
+    TxAckTracker::Stats txAckStats() const;
 
 private:
     std::string _baseUrl;
@@ -80,19 +169,21 @@ private:
     std::string _sendTxPath;     // relative path
     std::optional<std::string> _signedTx;
 
-    // Локальный signer
-    std::optional<LighterSigner> _signer;
-    std::optional<std::string> _signerDllPath;
-    std::optional<std::string> _apiKeyPrivate;
+    // Локальный signer: библиотека и клиент создаются один раз в setSignerConfig
+    std::unique_ptr<SignerSession> _signer;
+    bool signerReady();
     int _chainId = 304;
-    int _apiKeyIndex = 0;
     long long _accountIndex = 0;
     int _marketIndex = -1;
     long long _baseAmountScale = 0; // множитель количества -> base_amount(int)
     int _priceScale = 0;            // множитель цены -> price(int)
     double _defaultSlippage = 0.075; // 0.5%
 
-    static MarketDepth parseMarketDepthJson(const std::string &json);
+    static MarketDepth parseMarketDepthJson(const std::string &json, long long priceScale, long long sizeScale);
+    static int checkedPriceInt(long long priceInt);
+    // Тело и заголовки changeAccountTier (свежий auth token, если есть signer)
+    void buildChangeAccountTier(long long accountIndex, const std::string &newTier,
+                                std::string &body, std::vector<std::string> &headers);
 
     /*
      * getAccettablePriceInt считает цену для операции без учета спреда
@@ -103,17 +194,67 @@ private:
      * changePriceIfBadSpread делит цену на 100 если спред плохой
      */
 
-    // WS для ускоренной отправки jsonapi/sendtx
+    // Nonce по ключам: выдача из памяти, сверка с /api/v1/nextNonce в фоне после отказов.
+    // Объявлен до трекера и сокета — их колбэки сообщают итоги транзакций, пока те живы
+    std::unique_ptr<NonceManager> _nonces;
+    NonceManager &nonces();
+    long long fetchNextNonce(int apiKeyIndex);
+    std::future<long long> fetchNextNonceAsync(int apiKeyIndex);
+
+    // Схлопывание modify по orderIndex; его колбэки живут в трекере — объявлен раньше него
+    std::unique_ptr<ModifyCoalescer> _modifyCoalescer;
+    // modify мимо схлопывания: предподписанный или через конвейер
+    void dispatchModifyOrder(const std::string &id, long long orderIndex, long long baseAmountInt, long long priceInt,
+                             TxAckTracker::Callback onAck);
+
+    // WS для ускоренной отправки jsonapi/sendtx; трекер объявлен раньше — сокет, который в него пишет, умрёт первым
+    int _txAckTimeoutMs = 5000;
+    std::unique_ptr<TxAckTracker> _txAcks;
     std::unique_ptr<LighterTxWS> _txWs;
+    std::once_flag _txWsOnce;
+    std::atomic<unsigned long long> _txSeq{0};
     void ensureTxWs();
-    std::string sendTxOverWs(int txType, const std::string &txInfoJson);
-
-    // Nonce: потокобезопасное получение next_nonce с кэшем и авто-инкрементом
-    mutable std::mutex _nonceMtx;
-    bool _nonceInitialized = false;
-    long long _nextNonceCached = 0;
-    long long fetchNextNonce();
-    long long acquireNextNonce();
+    void createTxWs();
+    std::string nextTxId();
+    // onAck забирается только после того, как кадр встал в трекер: до этого исключение его не теряет
+    void sendTxOverWs(const std::string &id, int txType, const std::string &txInfoJson, const NonceLease &lease,
+                      TxAckTracker::Callback &&onAck);
+
+    // Подпись без отправки (ключ и nonce уже выданы); ошибка — исключением
+    std::string signCreateOrderTx(bool isAsk, long long baseAmountInt, int priceArg, const NonceLease &lease);
+    std::string signModifyOrderTx(long long orderIndex, long long baseAmountInt, int priceArg, const NonceLease &lease);
+    std::string signCancelAllTx(int timeInForce, long long time, const NonceLease &lease);
+
+    // Token bucket перед выдачей nonce
+    double _txRatePerSec = 40.0;
+    double _txBurst = 40.0;
+    std::once_flag _schedulerOnce;
+    std::unique_ptr<TxScheduler> _scheduler;
+    // деструктор начался: schedule() сразу отказывает (onAck из очереди может прислать новую задачу)
+    std::atomic<bool> _stopping{false};
+    TxScheduler &scheduler();
+    // Поставить отправку в очередь лимита; если отложенная отправка упадёт, onAck получит Rejected
+    void schedule(TxScheduler::Priority priority, const std::string &id, int txType, TxAckTracker::Callback onAck,
+                  std::function<void(TxAckTracker::Callback)> dispatch);
+    void dispatchCreateOrder(const std::string &id, bool isAsk, long long baseAmountInt, long long priceInt,
+                             TxAckTracker::Callback onAck);
+
+    // Асинхронный конвейер подписи; останавливается в деструкторе первым
+    int _signWorkers = 2;
+    std::once_flag _pipelineOnce;
+    std::unique_ptr<OrderPipeline> _pipeline;
+    OrderPipeline &pipeline();
+
+    // Поток лестницы подписывает через signer и читает nonce; останавливается в деструкторе после конвейера
+    std::unique_ptr<PresignedLadder> _ladder;
+    std::mutex _presignSendMtx; // выдача nonce ключа лестницы и отправка кадра — парой
+    bool trySendPresigned(std::initializer_list<PresignedLadder::Key> keys, const std::string &id,
+                          TxAckTracker::Callback &onAck);
+
+    // cancel-all в режиме tif (CANCEL_ALL_TIF_*) через конвейер
+    std::string submitCancelAll(int timeInForce, long long time, TxAckTracker::Callback onAck);
+    // Продления dead-man switch идут через конвейер — останавливаются в деструкторе раньше него
+    std::unique_ptr<CancelAllHeartbeat> _cancelAllHeartbeat;
 
 };
 
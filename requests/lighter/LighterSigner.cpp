@@ -21,6 +21,16 @@ std::optional<std::string> LighterSigner::createClient(
     return std::make_optional<std::string>("LighterSigner is not supported on Windows in this setup");
 }
 
+std::optional<std::string> LighterSigner::checkClient(int apiKeyIndex, long long accountIndex) {
+    (void)apiKeyIndex; (void)accountIndex;
+    return std::make_optional<std::string>("LighterSigner is not supported on Windows in this setup");
+}
+
+std::optional<std::string> LighterSigner::switchApiKey(int apiKeyIndex) {
+    (void)apiKeyIndex;
+    return std::make_optional<std::string>("LighterSigner is not supported on Windows in this setup");
+}
+
 std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner::signCreateOrder(
         int marketIndex,
         long long clientOrderIndex,
@@ -51,6 +61,22 @@ std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner:
     return {std::nullopt, std::make_optional<std::string>("LighterSigner not available on Windows")};
 }
 
+std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner::signCancelOrder(
+        int marketIndex,
+        long long orderIndex,
+        long long nonce) {
+    (void)marketIndex; (void)orderIndex; (void)nonce;
+    return {std::nullopt, std::make_optional<std::string>("LighterSigner not available on Windows")};
+}
+
+std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner::signCancelAllOrders(
+        int timeInForce,
+        long long time,
+        long long nonce) {
+    (void)timeInForce; (void)time; (void)nonce;
+    return {std::nullopt, std::make_optional<std::string>("LighterSigner not available on Windows")};
+}
+
 std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner::createAuthToken(long long deadlineEpochSeconds) {
     (void)deadlineEpochSeconds;
     return {std::nullopt, std::make_optional<std::string>("CreateAuthToken not available on Windows")};
@@ -64,9 +90,13 @@ LighterSigner::LighterSigner(const std::string &dllPath) : m_dllPath(dllPath), m
     m_lib = dlopen(dllPath.c_str(), RTLD_LAZY);
     if (m_lib) {
         m_createClient = reinterpret_cast<CreateClientFn>(dlsym(m_lib, "CreateClient"));
+        m_checkClient = reinterpret_cast<CheckClientFn>(dlsym(m_lib, "CheckClient"));
+        m_switchApiKey = reinterpret_cast<SwitchApiKeyFn>(dlsym(m_lib, "SwitchAPIKey"));
         m_signCreateOrder = reinterpret_cast<SignCreateOrderFn>(dlsym(m_lib, "SignCreateOrder"));
         m_createAuthToken = reinterpret_cast<CreateAuthTokenFn>(dlsym(m_lib, "CreateAuthToken"));
         m_signModifyOrder = reinterpret_cast<SignModifyOrderFn>(dlsym(m_lib, "SignModifyOrder"));
+        m_signCancelOrder = reinterpret_cast<SignCancelOrderFn>(dlsym(m_lib, "SignCancelOrder"));
+        m_signCancelAllOrders = reinterpret_cast<SignCancelAllOrdersFn>(dlsym(m_lib, "SignCancelAllOrders"));
     }
 }
 
@@ -90,6 +120,22 @@ std::optional<std::string> LighterSigner::createClient(
     return std::nullopt;
 }
 
+std::optional<std::string> LighterSigner::checkClient(int apiKeyIndex, long long accountIndex) {
+    if (!m_lib) return std::make_optional<std::string>("Signer DLL not loaded: " + m_dllPath);
+    if (!m_checkClient) return std::nullopt;
+    const char *err = m_checkClient(apiKeyIndex, accountIndex);
+    if (err) return std::make_optional<std::string>(cstrOrEmpty(err));
+    return std::nullopt;
+}
+
+std::optional<std::string> LighterSigner::switchApiKey(int apiKeyIndex) {
+    if (!m_lib) return std::make_optional<std::string>("Signer DLL not loaded: " + m_dllPath);
+    if (!m_switchApiKey) return std::make_optional<std::string>("Signer DLL: SwitchAPIKey not loaded");
+    const char *err = m_switchApiKey(apiKeyIndex);
+    if (err) return std::make_optional<std::string>(cstrOrEmpty(err));
+    return std::nullopt;
+}
+
 std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner::signModifyOrder(
     int marketIndex,
     long long clientOrderIndex,
@@ -131,6 +177,32 @@ std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner:
     return {std::make_optional<std::string>(s), std::nullopt};
 }
 
+std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner::signCancelOrder(
+        int marketIndex,
+        long long orderIndex,
+        long long nonce) {
+    if (!m_lib) return {std::nullopt, std::make_optional<std::string>("DLL not loaded: " + m_dllPath)};
+    if (!m_signCancelOrder) return {std::nullopt, std::make_optional<std::string>("SignCancelOrder not loaded")};
+    LighterStrOrErr r = m_signCancelOrder(marketIndex, orderIndex, nonce);
+    const std::string s = cstrOrEmpty(r.str);
+    const std::string e = cstrOrEmpty(r.err);
+    if (!e.empty()) return {std::nullopt, std::make_optional<std::string>(e)};
+    return {std::make_optional<std::string>(s), std::nullopt};
+}
+
+std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner::signCancelAllOrders(
+        int timeInForce,
+        long long time,
+        long long nonce) {
+    if (!m_lib) return {std::nullopt, std::make_optional<std::string>("DLL not loaded: " + m_dllPath)};
+    if (!m_signCancelAllOrders) return {std::nullopt, std::make_optional<std::string>("SignCancelAllOrders not loaded")};
+    LighterStrOrErr r = m_signCancelAllOrders(timeInForce, time, nonce);
+    const std::string s = cstrOrEmpty(r.str);
+    const std::string e = cstrOrEmpty(r.err);
+    if (!e.empty()) return {std::nullopt, std::make_optional<std::string>(e)};
+    return {std::make_optional<std::string>(s), std::nullopt};
+}
+
 std::pair<std::optional<std::string>, std::optional<std::string>> LighterSigner::createAuthToken(long long deadlineEpochSeconds) {
     if (!m_lib) return {std::nullopt, std::make_optional<std::string>("DLL not loaded: " + m_dllPath)};
     if (!m_createAuthToken) return {std::nullopt, std::make_optional<std::string>("CreateAuthToken not loaded")};
@@ -19,6 +19,14 @@ public:
     explicit LighterSigner(const std::string &dllPath);
     ~LighterSigner();
 
+    // владеет хэндлом dlopen: копия закрыла бы библиотеку в деструкторе
+    LighterSigner(const LighterSigner &) = delete;
+    LighterSigner &operator=(const LighterSigner &) = delete;
+
+    bool loaded() const { return m_lib != nullptr; }
+    bool canCheckClient() const { return m_checkClient != nullptr; }
+    bool canSwitchApiKey() const { return m_switchApiKey != nullptr; }
+
     std::optional<std::string> createClient(
             const std::string &url,
             const std::string &apiKeyPrivateHex,
@@ -27,6 +35,13 @@ public:
             long long accountIndex
     );
 
+    // Проверка клиента на стороне библиотеки (ключ совпадает с зарегистрированным);
+    // если в сборке signer'а нет CheckClient — nullopt, проверить нечем
+    std::optional<std::string> checkClient(int apiKeyIndex, long long accountIndex);
+
+    // Сделать активным ранее созданный клиент другого api key (подписи идут от активного)
+    std::optional<std::string> switchApiKey(int apiKeyIndex);
+
     std::pair<std::optional<std::string>, std::optional<std::string>> signCreateOrder(
             int marketIndex,
             long long clientOrderIndex,
@@ -50,6 +65,19 @@ public:
         long long nonce
     );
 
+    std::pair<std::optional<std::string>, std::optional<std::string>> signCancelOrder(
+            int marketIndex,
+            long long orderIndex,
+            long long nonce
+    );
+
+    // timeInForce — CANCEL_ALL_TIF_*; time — для SCHEDULED момент снятия (мс с эпохи), иначе 0
+    std::pair<std::optional<std::string>, std::optional<std::string>> signCancelAllOrders(
+            int timeInForce,
+            long long time,
+            long long nonce
+    );
+
     // Создать auth-токен с истечением срока в секундах с эпохи (Unix time)
     // не понял как сделать без expire todo
     std::pair<std::optional<std::string>, std::optional<std::string>> createAuthToken(long long deadlineEpochSeconds);
@@ -60,15 +88,23 @@ private:
 
     // работает, значит не трогаем
     using CreateClientFn = const char *(*)(const char *, const char *, int, int, long long);
+    using CheckClientFn = const char *(*)(int, long long);
+    using SwitchApiKeyFn = const char *(*)(int);
     using SignCreateOrderFn = LighterStrOrErr(*)(int, long long, long long, int, int, int, int, int, int, long long, long long);
     using CreateAuthTokenFn = LighterStrOrErr(*)(long long);
     using SignModifyOrderFn = LighterStrOrErr(*)(int, long long, long long, long long, long long, long long);
+    using SignCancelOrderFn = LighterStrOrErr(*)(int, long long, long long);
+    using SignCancelAllOrdersFn = LighterStrOrErr(*)(int, long long, long long);
 
 
     CreateClientFn m_createClient;
+    CheckClientFn m_checkClient = nullptr;
+    SwitchApiKeyFn m_switchApiKey = nullptr;
     SignCreateOrderFn m_signCreateOrder;
     CreateAuthTokenFn m_createAuthToken;
     SignModifyOrderFn m_signModifyOrder;
+    SignCancelOrderFn m_signCancelOrder = nullptr;
+    SignCancelAllOrdersFn m_signCancelAllOrders = nullptr;
 };
 
 
@@ -1,23 +1,26 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
-#include <thread>
 #include <atomic>
-#include <mutex>
-#include <condition_variable>
-#include <deque>
 #include <memory>
 
+#include "../../MarketDepths/WsSupervisor.h"
+
 // Класс веб‑сокета для сделок Lighter: держит соединение и
 // предоставляет неблокирующую отправку текстовых сообщений.
+// Сессия крутится на общем NetLoop, чтение и запись сериализованы её strand'ом.
 class LighterTxWS {
 public:
     struct Config {
         std::string url;                       // wss://host[:port]/stream
         std::vector<std::string> extraHeaders; // например Authorization: Bearer <token>
-        std::function<void(const std::string&)> onMessage; // входящие текстовые сообщения
+        std::function<void(std::string_view)> onMessage; // входящие текстовые сообщения, срез валиден только на время вызова
+        NetLoop *loop = nullptr;               // nullptr — NetLoop::shared(); для busy-poll — свой NetLoop(1, true)
+        size_t sendQueueSlots = 1024;          // кольцо исходящих: пачка ордеров не должна упираться в медленный путь
+        size_t sendSlotBytes = 1024;           // подписанный sendtx — порядка нескольких сотен байт
     };
 
     explicit LighterTxWS(Config cfg);
@@ -29,22 +32,10 @@ public:
     // Потокобезопасная отправка произвольного текстового сообщения
     void sendText(const std::string &text);
 
-private:
-    void run();
-    void writerLoop();
+    WsSupervisor::Stats connectionStats() const { return _supervisor->stats(); }
 
+private:
     Config _cfg;
-    std::thread _readThread;
-    std::thread _writeThread;
     std::atomic<bool> _running{false};
-
-    // Очередь исходящих сообщений
-    std::mutex _sendMtx;
-    std::condition_variable _sendCv;
-    std::deque<std::string> _sendQueue;
-
-    // type-erased указатель на внутренний websocket stream boost::beast
-    std::shared_ptr<void> _wsHolder;
+    std::unique_ptr<WsSupervisor> _supervisor;
 };
-
-
@@ -0,0 +1,97 @@
+#include "ModifyCoalescer.h"
+
+#include <iostream>
+
+ModifyCoalescer::ModifyCoalescer(Config cfg) : _cfg(std::move(cfg)) {}
+
+void ModifyCoalescer::submit(const std::string &id, long long orderIndex, const Intent &intent,
+                             TxAckTracker::Callback onAck) {
+    _submitted.fetch_add(1);
+    Pending p{id, intent, std::move(onAck)};
+    std::optional<Pending> replaced;
+    bool sendNow = false;
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        Slot &slot = _slots[orderIndex];
+        if (!slot.busy) {
+            slot.busy = true;
+            sendNow = true;
+        } else {
+            // цель ещё не ушла — её место занимает более свежая
+            if (slot.pending) replaced = std::move(slot.pending);
+            slot.pending = std::move(p);
+        }
+    }
+    if (replaced) {
+        _collapsed.fetch_add(1);
+        finish(*replaced, TxAck::Status::Superseded, "superseded by a newer modify");
+    }
+    if (!sendNow) return;
+    try {
+        dispatch(orderIndex, p);
+    } catch (...) {
+        onDone(orderIndex); // слот не должен остаться занятым навсегда
+        throw;
+    }
+}
+
+void ModifyCoalescer::dispatch(long long orderIndex, const Pending &p) {
+    TxAckTracker::Callback userAck = p.onAck;
+    _cfg.send(p.id, orderIndex, p.intent, [this, orderIndex, userAck](const TxAck &ack) {
+        if (userAck) userAck(ack);
+        onDone(orderIndex);
+    });
+    _sent.fetch_add(1);
+}
+
+void ModifyCoalescer::onDone(long long orderIndex) {
+    while (true) {
+        Pending next;
+        {
+            std::lock_guard<std::mutex> lk(_mtx);
+            auto it = _slots.find(orderIndex);
+            if (it == _slots.end()) return;
+            if (!it->second.pending) {
+                _slots.erase(it);
+                return;
+            }
+            next = std::move(*it->second.pending);
+            it->second.pending.reset();
+        }
+        try {
+            dispatch(orderIndex, next);
+            return;
+        } catch (const std::exception &ex) {
+            // отправить отложенную цель не вышло — сообщаем её владельцу и берём следующую, если успела прийти
+            std::cerr << "[ModifyCoalescer] order " << orderIndex << " modify failed: " << ex.what() << std::endl;
+            finish(next, TxAck::Status::Rejected, ex.what());
+        }
+    }
+}
+
+void ModifyCoalescer::finish(const Pending &p, TxAck::Status status, const std::string &message) {
+    if (!p.onAck) return;
+    TxAck ack;
+    ack.status = status;
+    ack.id = p.id;
+    ack.txType = _cfg.txType;
+    ack.message = message;
+    try {
+        p.onAck(ack);
+    } catch (const std::exception &ex) {
+        std::cerr << "[ModifyCoalescer] callback exception: " << ex.what() << std::endl;
+    }
+}
+
+ModifyCoalescer::Stats ModifyCoalescer::stats() const {
+    Stats s;
+    s.submitted = _submitted.load();
+    s.sent = _sent.load();
+    s.collapsed = _collapsed.load();
+    std::lock_guard<std::mutex> lk(_mtx);
+    for (const auto &kv : _slots) {
+        if (kv.second.busy) ++s.inFlight;
+        if (kv.second.pending) ++s.pending;
+    }
+    return s;
+}
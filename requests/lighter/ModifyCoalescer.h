@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <unordered_map>
+#include <mutex>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+#include "TxAckTracker.h"
+
+// Схлопывание modify по orderIndex: на ордер в полёте не больше одного modify (до ответа биржи),
+// а все новые цели, пришедшие за это время, заменяют друг друга — уйдёт только последняя.
+// Заменённые не подписываются и не тратят nonce; их onAck получает Superseded.
+class ModifyCoalescer {
+public:
+    struct Intent {
+        long long baseAmount{0};
+        long long price{0};
+    };
+
+    // Отправить modify; done — колбэк итога, его нужно передать в трекер как onAck. Ошибка — исключением
+    using SendFn = std::function<void(const std::string &id, long long orderIndex, const Intent &intent,
+                                      TxAckTracker::Callback done)>;
+
+    struct Config {
+        int txType = 0; // для TxAck заменённых
+        SendFn send;
+    };
+
+    struct Stats {
+        uint64_t submitted{0};
+        uint64_t sent{0};
+        uint64_t collapsed{0};   // заменены более новой целью, не отправлялись
+        size_t inFlight{0};      // ордеров с modify, ждущим ответа
+        size_t pending{0};       // ордеров с отложенной целью
+    };
+
+    explicit ModifyCoalescer(Config cfg);
+
+    // Отправляет сразу или откладывает до ответа на текущий modify этого ордера.
+    // Исключение — только если отправка сразу не удалась
+    void submit(const std::string &id, long long orderIndex, const Intent &intent, TxAckTracker::Callback onAck);
+
+    Stats stats() const;
+
+private:
+    struct Pending {
+        std::string id;
+        Intent intent;
+        TxAckTracker::Callback onAck;
+    };
+    struct Slot {
+        bool busy{false};
+        std::optional<Pending> pending;
+    };
+
+    void dispatch(long long orderIndex, const Pending &p);
+    void onDone(long long orderIndex);
+    void finish(const Pending &p, TxAck::Status status, const std::string &message);
+
+    Config _cfg;
+    mutable std::mutex _mtx;
+    std::unordered_map<long long, Slot> _slots;
+
+    std::atomic<uint64_t> _submitted{0};
+    std::atomic<uint64_t> _sent{0};
+    std::atomic<uint64_t> _collapsed{0};
+};
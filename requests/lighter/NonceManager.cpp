@@ -0,0 +1,244 @@
+#include "NonceManager.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+using Clock = std::chrono::steady_clock;
+
+NonceManager::NonceManager(Config cfg) : _cfg(std::move(cfg)) {
+    if (_cfg.apiKeyIndices.empty()) throw std::runtime_error("NonceManager: нужен хотя бы один api key");
+    for (int idx : _cfg.apiKeyIndices) {
+        Lane lane;
+        lane.apiKeyIndex = idx;
+        _lanes.push_back(lane); // needsFetch с прошедшим дедлайном — первый fetch сразу
+    }
+    _worker = std::thread([this]() { run(); });
+}
+
+NonceManager::~NonceManager() {
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        _stopping = true;
+    }
+    _cv.notify_all();
+    if (_worker.joinable()) _worker.join();
+}
+
+NonceManager::Lane *NonceManager::findLocked(int apiKeyIndex) {
+    for (auto &l : _lanes) {
+        if (l.apiKeyIndex == apiKeyIndex) return &l;
+    }
+    return nullptr;
+}
+
+const NonceManager::Lane *NonceManager::nextReadyLocked(size_t &pos) const {
+    for (size_t i = 0; i < _lanes.size(); ++i) {
+        pos = (_rr + i) % _lanes.size();
+        if (_lanes[pos].ready && !_lanes[pos].reserved) return &_lanes[pos];
+    }
+    return nullptr;
+}
+
+void NonceManager::markForFetchLocked(Lane &lane) {
+    const bool wasReady = lane.ready;
+    lane.ready = false;
+    if (!lane.needsFetch) {
+        lane.needsFetch = true;
+        lane.settleDeadline = Clock::now() + std::chrono::milliseconds(_cfg.settleMs);
+    }
+    _cv.notify_one();
+    if (wasReady && _cfg.onChanged) _cfg.onChanged(lane.apiKeyIndex); // до сверки nonce ключа не выдаётся
+}
+
+NonceLease NonceManager::acquire() {
+    std::lock_guard<std::mutex> lk(_mtx);
+    size_t pos = 0;
+    if (!nextReadyLocked(pos)) {
+        ++_exhausted;
+        throw std::runtime_error("nonce: нет готового api key (идёт сверка с сервером)");
+    }
+    Lane &lane = _lanes[pos];
+    NonceLease lease{lane.apiKeyIndex, lane.next++};
+    lane.inFlight.insert(lease.nonce);
+    ++lane.issued;
+    _rr = pos + 1;
+    if (_cfg.onChanged) _cfg.onChanged(lane.apiKeyIndex);
+    return lease;
+}
+
+bool NonceManager::reserve(int apiKeyIndex) {
+    std::lock_guard<std::mutex> lk(_mtx);
+    Lane *lane = findLocked(apiKeyIndex);
+    if (!lane) return false;
+    if (lane->reserved) return true;
+    const auto open = std::count_if(_lanes.begin(), _lanes.end(), [](const Lane &l) { return !l.reserved; });
+    if (open <= 1) return false; // обычным транзакциям нужен хотя бы один ключ
+    lane->reserved = true;
+    return true;
+}
+
+NonceLease NonceManager::peek(int apiKeyIndex) const {
+    std::lock_guard<std::mutex> lk(_mtx);
+    for (const auto &l : _lanes) {
+        if (l.apiKeyIndex != apiKeyIndex) continue;
+        if (!l.reserved) throw std::runtime_error("nonce: api key не зарезервирован");
+        if (!l.ready) throw std::runtime_error("nonce: api key на сверке с сервером");
+        return {l.apiKeyIndex, l.next};
+    }
+    throw std::runtime_error("nonce: нет такого api key");
+}
+
+bool NonceManager::takeIf(const NonceLease &expected) {
+    std::lock_guard<std::mutex> lk(_mtx);
+    Lane *lane = findLocked(expected.apiKeyIndex);
+    // ключ из круга acquire() сюда не годится: его предыдущий nonce может ещё подписываться в конвейере
+    if (!lane || !lane->reserved || !lane->ready || lane->next != expected.nonce) return false;
+    ++lane->next;
+    lane->inFlight.insert(expected.nonce);
+    ++lane->issued;
+    if (_cfg.onChanged) _cfg.onChanged(lane->apiKeyIndex);
+    return true;
+}
+
+void NonceManager::onAccepted(const NonceLease &lease) {
+    std::lock_guard<std::mutex> lk(_mtx);
+    Lane *lane = findLocked(lease.apiKeyIndex);
+    if (!lane || !lane->inFlight.erase(lease.nonce)) return;
+    ++_accepted;
+    // ключ ждёт сверки: последний ответ «в полёте» — можно перечитывать, не дожидаясь settleMs
+    if (lane->needsFetch && lane->inFlight.empty()) _cv.notify_one();
+}
+
+void NonceManager::onFailed(const NonceLease &lease, const std::string &reason) {
+    std::lock_guard<std::mutex> lk(_mtx);
+    Lane *lane = findLocked(lease.apiKeyIndex);
+    // nonce уже не числится (до сверки или запоздалый ответ) — сверка по нему была или идёт
+    if (!lane || !lane->inFlight.erase(lease.nonce)) return;
+    ++lane->failed;
+    if (!lane->needsFetch) {
+        std::cerr << "[NonceManager] key " << lane->apiKeyIndex << " nonce " << lease.nonce
+                  << " failed, reconciling: " << reason << std::endl;
+    }
+    markForFetchLocked(*lane);
+}
+
+void NonceManager::reconcile(int apiKeyIndex) {
+    std::lock_guard<std::mutex> lk(_mtx);
+    if (Lane *lane = findLocked(apiKeyIndex)) markForFetchLocked(*lane);
+}
+
+void NonceManager::setOnChanged(std::function<void(int apiKeyIndex)> cb) {
+    std::lock_guard<std::mutex> lk(_mtx);
+    _cfg.onChanged = std::move(cb);
+}
+
+void NonceManager::run() {
+    while (true) {
+        std::vector<int> dueKeys;
+        {
+            std::unique_lock<std::mutex> lk(_mtx);
+            while (true) {
+                if (_stopping) return;
+                // ключ к сверке: ответы на его транзакции пришли или ждать их больше нечего
+                const auto now = Clock::now();
+                auto wake = Clock::time_point::max();
+                for (auto &l : _lanes) {
+                    if (!l.needsFetch) continue;
+                    if (now >= l.settleDeadline || (l.inFlight.empty() && !l.fetchFailed)) {
+                        dueKeys.push_back(l.apiKeyIndex);
+                        if (!_cfg.fetchAsync) break; // синхронно — по одному
+                        continue;
+                    }
+                    wake = std::min(wake, l.settleDeadline);
+                }
+                if (!dueKeys.empty()) break;
+                if (wake == Clock::time_point::max()) _cv.wait(lk);
+                else _cv.wait_until(lk, wake);
+            }
+        }
+
+        if (_cfg.fetchAsync) {
+            // все запросы сразу в полёт — холодный старт и сверка нескольких ключей стоят один round trip
+            std::vector<std::pair<int, std::future<long long>>> pending;
+            for (int key : dueKeys) {
+                try {
+                    pending.emplace_back(key, _cfg.fetchAsync(key));
+                } catch (const std::exception &ex) {
+                    applyFetched(key, std::nullopt, ex.what());
+                }
+            }
+            for (auto &[key, fut] : pending) {
+                std::optional<long long> fetched;
+                std::string error;
+                try {
+                    fetched = fut.get();
+                } catch (const std::exception &ex) {
+                    error = ex.what();
+                }
+                applyFetched(key, fetched, error);
+            }
+            continue;
+        }
+        const int apiKeyIndex = dueKeys.front();
+        std::optional<long long> fetched;
+        std::string error;
+        try {
+            fetched = _cfg.fetch(apiKeyIndex);
+        } catch (const std::exception &ex) {
+            error = ex.what();
+        }
+        applyFetched(apiKeyIndex, fetched, error);
+    }
+}
+
+void NonceManager::applyFetched(int apiKeyIndex, std::optional<long long> fetched, const std::string &error) {
+    if (!fetched) {
+        std::cerr << "[NonceManager] key " << apiKeyIndex << " nextNonce failed: " << error << std::endl;
+        std::lock_guard<std::mutex> lk(_mtx);
+        ++_fetchErrors;
+        if (Lane *lane = findLocked(apiKeyIndex)) {
+            lane->fetchFailed = true;
+            lane->settleDeadline = Clock::now() + std::chrono::milliseconds(_cfg.retryMs);
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> lk(_mtx);
+    Lane *lane = findLocked(apiKeyIndex);
+    if (!lane) return;
+    // сервер — источник истины: всё, что не дошло до него к этому моменту, считаем потерянным
+    lane->next = *fetched;
+    lane->inFlight.clear();
+    lane->needsFetch = false;
+    lane->fetchFailed = false;
+    lane->ready = true;
+    // первая загрузка nonce — не сверка после сбоя
+    if (lane->loaded) ++lane->reconciles;
+    lane->loaded = true;
+    if (_cfg.onChanged) _cfg.onChanged(apiKeyIndex);
+}
+
+NonceManager::Stats NonceManager::stats() const {
+    Stats s;
+    std::lock_guard<std::mutex> lk(_mtx);
+    s.accepted = _accepted;
+    s.fetchErrors = _fetchErrors;
+    s.exhausted = _exhausted;
+    for (const auto &l : _lanes) {
+        KeyStats k;
+        k.apiKeyIndex = l.apiKeyIndex;
+        k.ready = l.ready;
+        k.reserved = l.reserved;
+        k.next = l.next;
+        k.inFlight = l.inFlight.size();
+        k.issued = l.issued;
+        k.failed = l.failed;
+        k.reconciles = l.reconciles;
+        s.issued += l.issued;
+        s.failed += l.failed;
+        s.reconciles += l.reconciles;
+        s.inFlight += l.inFlight.size();
+        s.keys.push_back(k);
+    }
+    return s;
+}
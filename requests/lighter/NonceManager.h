@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <optional>
+#include <chrono>
+#include <cstdint>
+
+// Выданный nonce вместе с ключом, которым его подписывать: у каждого api key своя последовательность
+struct NonceLease {
+    int apiKeyIndex{0};
+    long long nonce{0};
+
+    bool operator==(const NonceLease &o) const { return apiKeyIndex == o.apiKeyIndex && nonce == o.nonce; }
+    bool operator!=(const NonceLease &o) const { return !(*this == o); }
+};
+
+// Nonce для нескольких api key: выдача по кругу, учёт транзакций «в полёте» и сверка с сервером.
+// Выдача — только из памяти, сеть не трогает. Отказ, таймаут или сгоревшая подпись выводят ключ
+// из оборота: фоновый поток дожидается ответов на его остальные транзакции (не дольше settleMs),
+// перечитывает nextNonce и возвращает ключ в круг. Остальные ключи всё это время работают.
+// Ключ можно зарезервировать (reserve): он уходит из круга acquire(), и его nonce выдаёт только takeIf —
+// так у предподписи своя последовательность, которую обычные транзакции не сдвигают.
+class NonceManager {
+public:
+    struct Config {
+        std::vector<int> apiKeyIndices;              // порядок обхода
+        std::function<long long(int apiKeyIndex)> fetch; // REST nextNonce; ошибка — исключением
+        // Если задан — ключи, которым пора на сверку, читаются параллельно (ошибка — в future)
+        std::function<std::future<long long>(int apiKeyIndex)> fetchAsync;
+        // выданный nonce или сверка: «следующий» у ключа изменился (зовётся под внутренним локом)
+        std::function<void(int apiKeyIndex)> onChanged;
+        int settleMs = 2000;   // сколько ждать ответов «в полёте» перед сверкой
+        int retryMs = 500;     // пауза после неудачного fetch
+    };
+
+    struct KeyStats {
+        int apiKeyIndex{0};
+        bool ready{false};
+        bool reserved{false};
+        long long next{0};
+        size_t inFlight{0};
+        uint64_t issued{0};
+        uint64_t failed{0};
+        uint64_t reconciles{0};
+    };
+
+    struct Stats {
+        uint64_t issued{0};
+        uint64_t accepted{0};
+        uint64_t failed{0};
+        uint64_t reconciles{0};
+        uint64_t fetchErrors{0};
+        uint64_t exhausted{0};   // acquire без единого готового ключа
+        size_t inFlight{0};
+        std::vector<KeyStats> keys;
+    };
+
+    explicit NonceManager(Config cfg);
+    ~NonceManager();
+
+    // Следующий готовый незарезервированный ключ по кругу и его nonce; нет готовых — исключение (сети не ждём)
+    NonceLease acquire();
+    // Вывести ключ из круга acquire(). false — такого ключа нет или он последний в круге
+    bool reserve(int apiKeyIndex);
+    // Следующий nonce зарезервированного ключа, не забирая; ключ не готов — исключение
+    NonceLease peek(int apiKeyIndex) const;
+    // Выдать ровно expected, если это всё ещё следующий nonce зарезервированного ключа.
+    // Порядок отправки между вызовами takeIf — за владельцем ключа
+    bool takeIf(const NonceLease &expected);
+
+    // Итог транзакции с этим nonce
+    void onAccepted(const NonceLease &lease);
+    void onFailed(const NonceLease &lease, const std::string &reason);
+    // Сверить ключ с сервером (например, после ручного вмешательства)
+    void reconcile(int apiKeyIndex);
+    // Заменить onChanged; после возврата старый колбэк больше не вызывается
+    void setOnChanged(std::function<void(int apiKeyIndex)> cb);
+
+    Stats stats() const;
+
+private:
+    struct Lane {
+        int apiKeyIndex{0};
+        bool ready{false};
+        bool reserved{false};    // вне круга acquire()
+        bool needsFetch{true};
+        bool loaded{false};      // nonce хоть раз получен с сервера
+        bool fetchFailed{false}; // прошлый fetch упал: следующий — строго по дедлайну
+        long long next{0};
+        std::set<long long> inFlight;
+        std::chrono::steady_clock::time_point settleDeadline{};
+        uint64_t issued{0};
+        uint64_t failed{0};
+        uint64_t reconciles{0};
+    };
+
+    void run();
+    // под _mtx
+    Lane *findLocked(int apiKeyIndex);
+    const Lane *nextReadyLocked(size_t &pos) const;
+    void markForFetchLocked(Lane &lane);
+    // Итог чтения nonce ключа: значение или текст ошибки
+    void applyFetched(int apiKeyIndex, std::optional<long long> fetched, const std::string &error);
+
+    Config _cfg;
+    std::thread _worker;
+
+    mutable std::mutex _mtx;
+    std::condition_variable _cv;
+    bool _stopping{false};
+    std::vector<Lane> _lanes;
+    size_t _rr{0};
+
+    uint64_t _accepted{0};
+    uint64_t _fetchErrors{0};
+    uint64_t _exhausted{0};
+};
@@ -0,0 +1,161 @@
+#include "OrderPipeline.h"
+
+#include <algorithm>
+#include <iostream>
+
+OrderPipeline::OrderPipeline(Config cfg) : _cfg(std::move(cfg)) {
+    const int n = std::max(_cfg.workers, 1);
+    for (int i = 0; i < n; ++i) _workers.emplace_back([this]() { workerLoop(); });
+}
+
+OrderPipeline::~OrderPipeline() { stop(); }
+
+void OrderPipeline::stop() {
+    {
+        std::lock_guard<std::mutex> lk(_queueMtx);
+        if (_stopping) return;
+        _stopping = true;
+    }
+    _queueCv.notify_all();
+    for (auto &t : _workers) {
+        if (t.joinable()) t.join();
+    }
+    // воркеры стоят: оставшееся уже не уйдёт, но владельцы (coalescer, стратегия) ждут исхода
+    std::vector<Job> dropped;
+    {
+        std::lock_guard<std::mutex> lk(_queueMtx);
+        for (auto &job : _queue) dropped.push_back(std::move(job));
+        _queue.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lk(_sendMtx);
+        for (auto &entry : _ready) dropped.push_back(std::move(entry.second.job));
+        _ready.clear();
+    }
+    _dropped.fetch_add(dropped.size());
+    for (auto &job : dropped) reject(job, "pipeline stopped");
+}
+
+void OrderPipeline::reject(Job &job, const std::string &message) {
+    if (!job.onAck) return;
+    TxAck ack;
+    ack.status = TxAck::Status::Rejected;
+    ack.id = job.id;
+    ack.txType = job.txType;
+    ack.apiKeyIndex = job.lease.apiKeyIndex;
+    ack.nonce = job.lease.nonce;
+    ack.message = message;
+    job.onAck(ack);
+}
+
+void OrderPipeline::submit(const std::string &id, int txType, SignFn sign, TxAckTracker::Callback onAck) {
+    Job job{0, {}, txType, id, std::move(sign), std::move(onAck), std::chrono::steady_clock::now()};
+    {
+        std::lock_guard<std::mutex> lk(_submitMtx);
+        // в очередь под тем же локом: иначе задача с большим seq может встать раньше
+        std::lock_guard<std::mutex> qlk(_queueMtx);
+        if (!_stopping) {
+            job.lease = _cfg.acquireNonce();
+            job.seq = _nextSeq++;
+            _queue.push_back(std::move(job));
+            _submitted.fetch_add(1);
+            _queueCv.notify_one();
+            return;
+        }
+    }
+    // nonce не брали: остановленный конвейер его уже не отправит
+    reject(job, "pipeline stopped");
+    _queueCv.notify_one();
+}
+
+void OrderPipeline::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lk(_queueMtx);
+            _queueCv.wait(lk, [this] { return _stopping || !_queue.empty(); });
+            if (_stopping) return;
+            job = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        Signed done{std::move(job), {}, {}};
+        try {
+            done.payload = done.job.sign(done.job.lease);
+        } catch (const std::exception &ex) {
+            done.error = std::string("sign error: ") + ex.what();
+        }
+        complete(std::move(done));
+    }
+}
+
+void OrderPipeline::complete(Signed done) {
+    std::vector<Signed> failed;
+    {
+        std::lock_guard<std::mutex> lk(_sendMtx);
+        const uint64_t seq = done.job.seq;
+        _ready.emplace(seq, std::move(done));
+        // отправляем всё, что стало непрерывным от _nextSend
+        for (auto it = _ready.begin(); it != _ready.end() && it->first == _nextSend; it = _ready.erase(it), ++_nextSend) {
+            Signed &s = it->second;
+            const int key = s.job.lease.apiKeyIndex;
+            if (auto burnt = _burntNonce.find(key); burnt != _burntNonce.end()) {
+                if (s.job.lease.nonce > burnt->second) {
+                    // за сгоревшим nonce сервер отклонит и этот — не тратим на него лимит и сокет
+                    s.error = "previous nonce " + std::to_string(burnt->second) + " failed";
+                    _skipped.fetch_add(1);
+                    failed.push_back(std::move(s));
+                    continue;
+                }
+                _burntNonce.erase(burnt); // nonce не больше сгоревшего — ключ уже сверен
+            }
+            if (!s.error.empty()) {
+                _signErrors.fetch_add(1);
+                _burntNonce[key] = s.job.lease.nonce;
+                failed.push_back(std::move(s));
+                continue;
+            }
+            try {
+                _cfg.send(s.job.id, s.job.txType, s.payload, s.job.lease, std::move(s.job.onAck));
+            } catch (const std::exception &ex) {
+                // исключение из потока воркера — это std::terminate; nonce не ушёл, как при ошибке подписи
+                s.error = std::string("send error: ") + ex.what();
+                _sendErrors.fetch_add(1);
+                _burntNonce[key] = s.job.lease.nonce;
+                failed.push_back(std::move(s));
+                continue;
+            }
+            const long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - s.job.submittedAt).count();
+            _sent.fetch_add(1);
+            _lastSubmitToSendUs.store(us);
+            long long prev = _maxSubmitToSendUs.load();
+            while (us > prev && !_maxSubmitToSendUs.compare_exchange_weak(prev, us)) {}
+        }
+    }
+    // колбэки ошибок — вне лока отправки
+    for (auto &s : failed) {
+        std::cerr << "[OrderPipeline] tx failed id=" << s.job.id << " key=" << s.job.lease.apiKeyIndex
+                  << " nonce=" << s.job.lease.nonce << ": " << s.error << std::endl;
+        if (_cfg.onSignError) _cfg.onSignError(s.job.lease, s.error);
+        reject(s.job, s.error);
+    }
+}
+
+bool OrderPipeline::idle() const {
+    return _submitted.load() <= _sent.load() + _signErrors.load() + _sendErrors.load() + _skipped.load() + _dropped.load();
+}
+
+OrderPipeline::Stats OrderPipeline::stats() const {
+    Stats s;
+    s.submitted = _submitted.load();
+    s.sent = _sent.load();
+    s.signErrors = _signErrors.load();
+    s.sendErrors = _sendErrors.load();
+    s.skipped = _skipped.load();
+    s.dropped = _dropped.load();
+    const uint64_t done = s.sent + s.signErrors + s.sendErrors + s.skipped + s.dropped;
+    s.inFlight = s.submitted > done ? (size_t)(s.submitted - done) : 0;
+    s.lastSubmitToSendUs = _lastSubmitToSendUs.load();
+    s.maxSubmitToSendUs = _maxSubmitToSendUs.load();
+    return s;
+}
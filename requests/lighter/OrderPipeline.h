@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "TxAckTracker.h"
+#include "NonceManager.h"
+
+// Асинхронная отправка транзакций: submit() на потоке стратегии только берёт nonce и ставит задачу,
+// подпись идёт параллельно в пуле потоков, а готовые кадры уходят строго в порядке nonce —
+// иначе сервер отклонит всё, что обогнало ещё не подписанный предыдущий nonce.
+class OrderPipeline {
+public:
+    // Подписать транзакцию ключом и nonce из lease; ошибка — исключением
+    using SignFn = std::function<std::string(const NonceLease &lease)>;
+
+    struct Config {
+        int workers = 2;
+        std::function<NonceLease()> acquireNonce;
+        // отправка подписанного кадра; зовётся под внутренним локом, в порядке выдачи nonce.
+        // onAck забирается только при успехе: исключение оставляет его конвейеру для ответа Rejected
+        std::function<void(const std::string &id, int txType, const std::string &payload, const NonceLease &lease,
+                           TxAckTracker::Callback &&onAck)> send;
+        // подпись или отправка не удалась: nonce сгорел, следующие за ним сервер отклонит — повод сверить nonce ключа.
+        // Уже выданные следующие nonce того же ключа конвейер не отправляет и сообщает сюда же
+        std::function<void(const NonceLease &lease, const std::string &error)> onSignError;
+    };
+
+    struct Stats {
+        uint64_t submitted{0};
+        uint64_t sent{0};
+        uint64_t signErrors{0};
+        uint64_t sendErrors{0};
+        uint64_t skipped{0};            // не отправлены: раньше сгорел nonce того же ключа
+        uint64_t dropped{0};            // не отправлены из-за stop()
+        size_t inFlight{0};             // поставлено, но ещё не отправлено
+        long long lastSubmitToSendUs{0};
+        long long maxSubmitToSendUs{0};
+    };
+
+    explicit OrderPipeline(Config cfg);
+    ~OrderPipeline();
+
+    // Не ждёт подписи; исключение — только если не удалось получить nonce.
+    // После stop() задача не ставится, onAck сразу получает Rejected
+    void submit(const std::string &id, int txType, SignFn sign, TxAckTracker::Callback onAck = {});
+
+    // Неотправленные задачи (в очереди и в буфере порядка) завершаются Rejected
+    void stop();
+    Stats stats() const;
+    // Нет поставленных и неотправленных задач; без локов, для фоновых потребителей signer
+    bool idle() const;
+
+private:
+    struct Job {
+        uint64_t seq;
+        NonceLease lease;
+        int txType;
+        std::string id;
+        SignFn sign;
+        TxAckTracker::Callback onAck;
+        std::chrono::steady_clock::time_point submittedAt;
+    };
+    struct Signed {
+        Job job;
+        std::string payload;
+        std::string error; // непусто — подпись или отправка не удалась
+    };
+
+    void workerLoop();
+    void complete(Signed done);
+    static void reject(Job &job, const std::string &message);
+
+    Config _cfg;
+    std::vector<std::thread> _workers;
+
+    std::mutex _submitMtx;  // nonce и seq выдаются парой, чтобы порядок seq совпадал с порядком nonce
+    uint64_t _nextSeq{0};
+
+    std::mutex _queueMtx;
+    std::condition_variable _queueCv;
+    std::deque<Job> _queue;
+    bool _stopping{false};
+
+    std::mutex _sendMtx;    // буфер переупорядочивания
+    std::map<uint64_t, Signed> _ready;
+    uint64_t _nextSend{0};
+    // ключ -> сгоревший nonce: бОльшие nonce этого ключа не отправляем, пока не придёт nonce не больше
+    // (выданный после сверки); seq идут в порядке выдачи, так что старые задачи всегда раньше новых
+    std::unordered_map<int, long long> _burntNonce;
+
+    std::atomic<uint64_t> _submitted{0};
+    std::atomic<uint64_t> _sent{0};
+    std::atomic<uint64_t> _signErrors{0};
+    std::atomic<uint64_t> _sendErrors{0};
+    std::atomic<uint64_t> _skipped{0};
+    std::atomic<uint64_t> _dropped{0};
+    std::atomic<long long> _lastSubmitToSendUs{0};
+    std::atomic<long long> _maxSubmitToSendUs{0};
+};
@@ -0,0 +1,172 @@
+#include "PresignedLadder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+PresignedLadder::PresignedLadder(Config cfg) : _cfg(std::move(cfg)) {
+    _worker = std::thread([this]() { run(); });
+}
+
+PresignedLadder::~PresignedLadder() {
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        _stopping = true;
+    }
+    _cv.notify_all();
+    if (_worker.joinable()) _worker.join();
+}
+
+void PresignedLadder::setBook(long long bidTicks, long long askTicks, long long tick, long long createBaseAmount) {
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        if (_target.bid == bidTicks && _target.ask == askTicks && _target.tick == tick &&
+            _target.createAmount == createBaseAmount) return;
+        _target.bid = bidTicks;
+        _target.ask = askTicks;
+        _target.tick = tick;
+        _target.createAmount = createBaseAmount;
+        _dirty = true;
+    }
+    _cv.notify_one();
+}
+
+void PresignedLadder::setModifyTarget(long long orderIndex, bool isAsk, long long baseAmount) {
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        if (_target.modifyOrderIndex == orderIndex && _target.modifyIsAsk == isAsk &&
+            _target.modifyAmount == baseAmount) return;
+        _target.modifyOrderIndex = orderIndex;
+        _target.modifyIsAsk = isAsk;
+        _target.modifyAmount = baseAmount;
+        _dirty = true;
+    }
+    _cv.notify_one();
+}
+
+void PresignedLadder::onNonceChanged() {
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        _entries.clear(); // подписаны ушедшим nonce — больше не годятся
+        ++_nonceEpoch;
+        _dirty = true;
+    }
+    _cv.notify_one();
+}
+
+std::optional<PresignedLadder::Entry> PresignedLadder::find(std::initializer_list<Key> keys) {
+    std::lock_guard<std::mutex> lk(_mtx);
+    for (const Key &key : keys) {
+        for (const auto &e : _entries) {
+            if (e.key == key) return e;
+        }
+    }
+    _misses.fetch_add(1);
+    return std::nullopt;
+}
+
+std::vector<PresignedLadder::Key> PresignedLadder::wantedKeys(const Target &t) const {
+    std::vector<Key> keys;
+    if (t.tick <= 0) return keys;
+    // от центра наружу: к моменту котирования ближние цены уже подписаны
+    for (int d = 0; d <= _cfg.windowTicks; ++d) {
+        for (int sign : {1, -1}) {
+            if (d == 0 && sign < 0) continue;
+            const long long off = sign * d * t.tick;
+            if (t.createAmount > 0) {
+                if (t.bid > 0 && t.bid + off > 0) keys.push_back({_cfg.createTxType, false, 0, t.createAmount, t.bid + off});
+                if (t.ask > 0 && t.ask + off > 0) keys.push_back({_cfg.createTxType, true, 0, t.createAmount, t.ask + off});
+            }
+            if (t.modifyOrderIndex != 0 && t.modifyAmount > 0) {
+                const long long center = t.modifyIsAsk ? t.ask : t.bid;
+                if (center > 0 && center + off > 0) {
+                    keys.push_back({_cfg.modifyTxType, t.modifyIsAsk, t.modifyOrderIndex, t.modifyAmount, center + off});
+                }
+            }
+        }
+    }
+    return keys;
+}
+
+void PresignedLadder::run() {
+    while (true) {
+        Target target;
+        uint64_t epoch;
+        {
+            std::unique_lock<std::mutex> lk(_mtx);
+            _cv.wait(lk, [this] { return _stopping || _dirty; });
+            if (_stopping) return;
+            _dirty = false;
+            target = _target;
+            epoch = _nonceEpoch;
+        }
+
+        NonceLease lease;
+        try {
+            lease = _cfg.peekNonce();
+        } catch (const std::exception &ex) {
+            std::cerr << "[PresignedLadder] nonce unavailable: " << ex.what() << std::endl;
+            std::unique_lock<std::mutex> lk(_mtx);
+            _dirty = true;
+            _cv.wait_for(lk, std::chrono::milliseconds(500), [this] { return _stopping; });
+            continue;
+        }
+
+        const std::vector<Key> wanted = wantedKeys(target);
+        std::vector<Key> missing;
+        {
+            std::lock_guard<std::mutex> lk(_mtx);
+            if (epoch != _nonceEpoch) continue; // nonce сдвинулся, пока читали — пересчёт уже запрошен
+            // выкидываем чужой nonce и цены, ушедшие из окна
+            _entries.erase(std::remove_if(_entries.begin(), _entries.end(), [&](const Entry &e) {
+                return e.lease != lease || std::find(wanted.begin(), wanted.end(), e.key) == wanted.end();
+            }), _entries.end());
+            for (const auto &k : wanted) {
+                const bool have = std::any_of(_entries.begin(), _entries.end(), [&](const Entry &e) { return e.key == k; });
+                if (!have) missing.push_back(k);
+            }
+        }
+
+        for (const auto &k : missing) {
+            if (_cfg.canSign && !_cfg.canSign()) {
+                // подпись лестницы делит signer с живыми транзакциями — уступаем им и пересчитываем позже
+                _yields.fetch_add(1);
+                std::unique_lock<std::mutex> lk(_mtx);
+                _dirty = true;
+                _cv.wait_for(lk, std::chrono::milliseconds(_cfg.busyBackoffMs), [this] { return _stopping; });
+                break;
+            }
+            Entry e{k, lease, {}};
+            try {
+                e.payload = _cfg.sign(k, lease);
+                _signs.fetch_add(1);
+            } catch (const std::exception &ex) {
+                _signErrors.fetch_add(1);
+                std::cerr << "[PresignedLadder] sign failed: " << ex.what() << std::endl;
+                continue;
+            }
+            std::lock_guard<std::mutex> lk(_mtx);
+            // nonce ушёл, пока подписывали, — подпись бесполезна; книга сдвинулась — запись оставляем
+            // (следующий проход отсеет её по окну), но порядок подписи пересчитываем от нового центра
+            if (_stopping || epoch != _nonceEpoch) break;
+            _entries.push_back(std::move(e));
+            if (_dirty) break;
+        }
+    }
+}
+
+PresignedLadder::Stats PresignedLadder::stats() const {
+    Stats s;
+    s.hits = _hits.load();
+    s.misses = _misses.load();
+    s.stale = _stale.load();
+    s.signs = _signs.load();
+    s.signErrors = _signErrors.load();
+    s.yields = _yields.load();
+    {
+        std::lock_guard<std::mutex> lk(_mtx);
+        s.ready = _entries.size();
+    }
+    return s;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <initializer_list>
+#include <atomic>
+#include <cstdint>
+
+#include "NonceManager.h"
+
+// Заранее подписанные create/modify на несколько тиков вокруг лучших цен.
+// Все записи подписаны одним и тем же «следующим» nonce выделенного ключа (обычные транзакции его
+// не берут): уйдёт максимум одна из них, и только если этот nonce всё ещё следующий (проверяет владелец nonce).
+// Неиспользованные записи ничего не резервируют — дыр в nonce не бывает; после любого
+// сдвига nonce или книги фоновый поток переподписывает лестницу, ближние к центру цены — первыми.
+class PresignedLadder {
+public:
+    struct Key {
+        int txType{0};
+        bool isAsk{false};
+        long long orderIndex{0}; // только для modify
+        long long baseAmount{0};
+        long long price{0};
+
+        bool operator==(const Key &o) const {
+            return txType == o.txType && isAsk == o.isAsk && orderIndex == o.orderIndex &&
+                   baseAmount == o.baseAmount && price == o.price;
+        }
+    };
+
+    struct Entry {
+        Key key;
+        NonceLease lease;
+        std::string payload;
+    };
+
+    struct Config {
+        int windowTicks = 2;  // цены center +- windowTicks
+        int createTxType = 0;
+        int modifyTxType = 0;
+        std::function<NonceLease()> peekNonce;                                 // следующий nonce, не забирая его
+        std::function<std::string(const Key &, const NonceLease &)> sign;      // ошибка — исключением
+        // можно ли подписывать сейчас; false — лестница уступает и ждёт busyBackoffMs. Пусто — всегда можно
+        std::function<bool()> canSign;
+        int busyBackoffMs = 2;
+    };
+
+    struct Stats {
+        uint64_t hits{0};      // нашли запись и отправили
+        uint64_t misses{0};    // записи на эту цену/объём не было
+        uint64_t stale{0};     // запись была, но её nonce уже ушёл
+        uint64_t signs{0};
+        uint64_t signErrors{0};
+        uint64_t yields{0};    // подпись отложена: canSign() == false
+        size_t ready{0};       // записей с актуальным nonce
+    };
+
+    explicit PresignedLadder(Config cfg);
+    ~PresignedLadder();
+
+    // Центр лестницы (тики стакана) и объём create; без изменений — без переподписи
+    void setBook(long long bidTicks, long long askTicks, long long tick, long long createBaseAmount);
+    // Активный ордер для modify; orderIndex == 0 — не подписывать modify
+    void setModifyTarget(long long orderIndex, bool isAsk, long long baseAmount);
+    // nonce сдвинулся (ушла транзакция или кэш сброшен) — всё подписанное устарело
+    void onNonceChanged();
+
+    // Копия первой найденной записи под любой из ключей (modify не знает стороны — обе); промах —
+    // один на вызов. Решение об отправке — за владельцем nonce
+    std::optional<Entry> find(std::initializer_list<Key> keys);
+    void noteHit() { _hits.fetch_add(1); }
+    void noteStale() { _stale.fetch_add(1); }
+
+    Stats stats() const;
+
+private:
+    struct Target {
+        long long bid{0}, ask{0}, tick{0}, createAmount{0};
+        long long modifyOrderIndex{0};
+        bool modifyIsAsk{false};
+        long long modifyAmount{0};
+    };
+
+    void run();
+    std::vector<Key> wantedKeys(const Target &t) const;
+
+    Config _cfg;
+    std::thread _worker;
+
+    mutable std::mutex _mtx;
+    std::condition_variable _cv;
+    bool _stopping{false};
+    bool _dirty{false};
+    uint64_t _nonceEpoch{0};   // растёт при сдвиге nonce: подписи прошлых эпох не годятся
+    Target _target;
+    std::vector<Entry> _entries;
+
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+    std::atomic<uint64_t> _stale{0};
+    std::atomic<uint64_t> _signs{0};
+    std::atomic<uint64_t> _signErrors{0};
+    std::atomic<uint64_t> _yields{0};
+};
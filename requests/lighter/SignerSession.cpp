@@ -0,0 +1,177 @@
+#include "SignerSession.h"
+
+#include <iostream>
+#include <mutex>
+
+using Clock = std::chrono::steady_clock;
+
+static long long elapsedUs(Clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since).count();
+}
+
+SignerSession::SignerSession(Config cfg)
+        : _cfg(std::move(cfg)), _primaryKey(_cfg.apiKeys.empty() ? 0 : _cfg.apiKeys.front().index) {}
+
+std::optional<std::string> SignerSession::open() {
+    std::unique_lock<std::shared_mutex> lk(_mtx);
+    return openLocked();
+}
+
+std::optional<std::string> SignerSession::openLocked() {
+    _lastOpenAttempt = Clock::now();
+    _ready.store(false);
+    if (_cfg.apiKeys.empty()) {
+        _lastError = "no api keys configured";
+        return _lastError;
+    }
+    if (!_signer) _signer = std::make_unique<LighterSigner>(_cfg.dllPath);
+    if (_cfg.apiKeys.size() > 1 && _signer->loaded() && !_signer->canSwitchApiKey()) {
+        // без SwitchAPIKey подписывает только последний созданный клиент — остаёмся на основном ключе
+        std::cerr << "[SignerSession] signer has no SwitchAPIKey, using api key " << _cfg.apiKeys.front().index
+                  << " only" << std::endl;
+        _cfg.apiKeys.resize(1);
+    }
+
+    std::optional<std::string> err;
+    for (const auto &key : _cfg.apiKeys) {
+        const auto t0 = Clock::now();
+        err = _signer->createClient(_cfg.url, key.privateHex, _cfg.chainId, key.index, _cfg.accountIndex);
+        _lastCreateUs.store(elapsedUs(t0));
+        _clientCreates.fetch_add(1);
+        if (!err) err = _signer->checkClient(key.index, _cfg.accountIndex);
+        if (err) break;
+        _activeKey = key.index; // CreateClient делает новый клиент активным
+    }
+    _multiKey.store(_cfg.apiKeys.size() > 1);
+    if (err) {
+        _lastError = *err;
+        std::cerr << "[SignerSession] client init failed: " << *err << std::endl;
+        return err;
+    }
+    _lastError.clear();
+    _ready.store(true);
+    return std::nullopt;
+}
+
+bool SignerSession::ensureReady() {
+    if (_ready.load()) return true;
+    std::unique_lock<std::shared_mutex> lk(_mtx);
+    if (_ready.load()) return true;
+    if (Clock::now() - _lastOpenAttempt < std::chrono::milliseconds(_cfg.reopenIntervalMs)) return false;
+    return !openLocked();
+}
+
+bool SignerSession::recover(int apiKeyIndex) {
+    std::unique_lock<std::shared_mutex> lk(_mtx);
+    // если библиотека умеет проверить клиента и он жив — ошибка в самих параметрах, пересоздание не поможет
+    if (_signer && _signer->canCheckClient() && !_signer->checkClient(apiKeyIndex, _cfg.accountIndex)) return false;
+    std::cerr << "[SignerSession] sign failed, re-creating client" << std::endl;
+    if (openLocked()) return false;
+    _recoveries.fetch_add(1);
+    return true;
+}
+
+template <typename F>
+SignerSession::SignResult SignerSession::timedSign(int apiKeyIndex, F &&call) {
+    if (_multiKey.load()) {
+        // активный клиент — общее состояние библиотеки: смена ключа и подпись не должны перемешаться
+        std::unique_lock<std::shared_mutex> lk(_mtx);
+        if (!_ready.load() || !_signer) {
+            return {std::nullopt, std::make_optional<std::string>("signer not ready: " + _lastError)};
+        }
+        if (_activeKey != apiKeyIndex) {
+            if (auto err = _signer->switchApiKey(apiKeyIndex)) return {std::nullopt, err};
+            _activeKey = apiKeyIndex;
+            _keySwitches.fetch_add(1);
+        }
+        return measured(call);
+    }
+    std::shared_lock<std::shared_mutex> lk(_mtx);
+    if (!_ready.load() || !_signer) {
+        return {std::nullopt, std::make_optional<std::string>("signer not ready: " + _lastError)};
+    }
+    return measured(call);
+}
+
+template <typename F>
+SignerSession::SignResult SignerSession::measured(F &&call) {
+    const auto t0 = Clock::now();
+    SignResult r = call(*_signer);
+    const long long us = elapsedUs(t0);
+    _signs.fetch_add(1);
+    if (r.second) _signErrors.fetch_add(1);
+    _lastSignUs.store(us);
+    _totalSignUs.fetch_add(us);
+    long long prev = _maxSignUs.load();
+    while (us > prev && !_maxSignUs.compare_exchange_weak(prev, us)) {}
+    return r;
+}
+
+template <typename F>
+SignerSession::SignResult SignerSession::signWithRecovery(int apiKeyIndex, F &&call) {
+    if (!ensureReady()) {
+        std::shared_lock<std::shared_mutex> lk(_mtx);
+        return {std::nullopt, std::make_optional<std::string>("signer not ready: " + _lastError)};
+    }
+    SignResult r = timedSign(apiKeyIndex, call);
+    if (!r.second || !recover(apiKeyIndex)) return r;
+    return timedSign(apiKeyIndex, call);
+}
+
+SignerSession::SignResult SignerSession::signCreateOrder(int apiKeyIndex, int marketIndex, long long clientOrderIndex, long long baseAmount,
+                                                         int price, int isAsk, int orderType, int timeInForce,
+                                                         int reduceOnly, int triggerPrice, long long orderExpiry,
+                                                         long long nonce) {
+    return signWithRecovery(apiKeyIndex, [&](LighterSigner &s) {
+        return s.signCreateOrder(marketIndex, clientOrderIndex, baseAmount, price, isAsk, orderType, timeInForce,
+                                 reduceOnly, triggerPrice, orderExpiry, nonce);
+    });
+}
+
+SignerSession::SignResult SignerSession::signModifyOrder(int apiKeyIndex, int marketIndex, long long orderIndex, long long baseAmount,
+                                                         int price, int triggerPrice, long long nonce) {
+    return signWithRecovery(apiKeyIndex, [&](LighterSigner &s) {
+        return s.signModifyOrder(marketIndex, orderIndex, baseAmount, price, triggerPrice, nonce);
+    });
+}
+
+SignerSession::SignResult SignerSession::signCancelOrder(int apiKeyIndex, int marketIndex, long long orderIndex,
+                                                         long long nonce) {
+    return signWithRecovery(apiKeyIndex, [&](LighterSigner &s) {
+        return s.signCancelOrder(marketIndex, orderIndex, nonce);
+    });
+}
+
+SignerSession::SignResult SignerSession::signCancelAllOrders(int apiKeyIndex, int timeInForce, long long time,
+                                                             long long nonce) {
+    return signWithRecovery(apiKeyIndex, [&](LighterSigner &s) {
+        return s.signCancelAllOrders(timeInForce, time, nonce);
+    });
+}
+
+SignerSession::SignResult SignerSession::createAuthToken(long long deadlineEpochSeconds) {
+    // токен — от основного ключа
+    return signWithRecovery(_primaryKey, [&](LighterSigner &s) { return s.createAuthToken(deadlineEpochSeconds); });
+}
+
+std::vector<int> SignerSession::apiKeyIndices() const {
+    std::shared_lock<std::shared_mutex> lk(_mtx);
+    std::vector<int> out;
+    for (const auto &k : _cfg.apiKeys) out.push_back(k.index);
+    return out;
+}
+
+SignerSession::Stats SignerSession::stats() const {
+    Stats s;
+    s.ready = _ready.load();
+    s.signs = _signs.load();
+    s.signErrors = _signErrors.load();
+    s.clientCreates = _clientCreates.load();
+    s.recoveries = _recoveries.load();
+    s.keySwitches = _keySwitches.load();
+    s.lastSignUs = _lastSignUs.load();
+    s.maxSignUs = _maxSignUs.load();
+    s.avgSignUs = s.signs ? (long long)(_totalSignUs.load() / (long long)s.signs) : 0;
+    s.lastCreateUs = _lastCreateUs.load();
+    return s;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <shared_mutex>
+#include <vector>
+#include <cstdint>
+
+#include "LighterSigner.h"
+
+// Один загруженный signer и по клиенту на каждый api key на весь процесс.
+// Библиотека и CreateClient — при open() на старте; дальше подписи идут без повторной инициализации.
+// Ошибка подписи -> проверка клиента (CheckClient) -> пересоздание и один повтор, только если клиент и правда потерян.
+// Активный клиент в библиотеке один на процесс: с одним ключом подписи идут параллельно,
+// с несколькими — по очереди, с SwitchAPIKey перед подписью чужим ключом.
+class SignerSession {
+public:
+    struct ApiKey {
+        int index = 0;
+        std::string privateHex;
+    };
+
+    struct Config {
+        std::string dllPath;
+        std::string url;
+        std::vector<ApiKey> apiKeys; // первый — основной (auth-токен)
+        int chainId = 304;
+        long long accountIndex = 0;
+        int reopenIntervalMs = 1000; // не чаще — повторный open() после неудачи
+    };
+
+    struct Stats {
+        bool ready{false};
+        uint64_t signs{0};
+        uint64_t signErrors{0};
+        uint64_t clientCreates{0};
+        uint64_t recoveries{0};      // клиент пересоздан после ошибки подписи
+        uint64_t keySwitches{0};     // SwitchAPIKey перед подписью
+        long long lastSignUs{0};
+        long long maxSignUs{0};
+        long long avgSignUs{0};
+        long long lastCreateUs{0};
+    };
+
+    // (подписанная транзакция, ошибка) — как у LighterSigner
+    using SignResult = std::pair<std::optional<std::string>, std::optional<std::string>>;
+
+    explicit SignerSession(Config cfg);
+
+    // Загрузить библиотеку (один раз) и создать клиентов; ошибка — текстом
+    std::optional<std::string> open();
+    bool ready() const { return _ready.load(); }
+    // Готов или удалось переоткрыть (не чаще reopenIntervalMs)
+    bool ensureReady();
+
+    // apiKeyIndex — ключ, чей nonce в транзакции
+    SignResult signCreateOrder(int apiKeyIndex, int marketIndex, long long clientOrderIndex, long long baseAmount, int price, int isAsk,
+                               int orderType, int timeInForce, int reduceOnly, int triggerPrice, long long orderExpiry,
+                               long long nonce);
+    SignResult signModifyOrder(int apiKeyIndex, int marketIndex, long long orderIndex, long long baseAmount, int price, int triggerPrice,
+                               long long nonce);
+    SignResult signCancelOrder(int apiKeyIndex, int marketIndex, long long orderIndex, long long nonce);
+    SignResult signCancelAllOrders(int apiKeyIndex, int timeInForce, long long time, long long nonce);
+    SignResult createAuthToken(long long deadlineEpochSeconds);
+
+    const Config &config() const { return _cfg; }
+    // Ключи, которыми реально можно подписывать (без SwitchAPIKey — только основной)
+    std::vector<int> apiKeyIndices() const;
+    Stats stats() const;
+
+private:
+    template <typename F>
+    SignResult signWithRecovery(int apiKeyIndex, F &&call);
+    template <typename F>
+    SignResult timedSign(int apiKeyIndex, F &&call);
+    template <typename F>
+    SignResult measured(F &&call);
+    std::optional<std::string> openLocked();
+    bool recover(int apiKeyIndex);
+
+    Config _cfg;
+    const int _primaryKey;
+    // подписи одним ключом — под shared (библиотека сама потокобезопасна);
+    // создание клиентов и подписи при нескольких ключах (смена активного) — под unique
+    mutable std::shared_mutex _mtx;
+    std::unique_ptr<LighterSigner> _signer;
+    int _activeKey{-1};
+    std::atomic<bool> _multiKey{false};
+    std::string _lastError;
+    std::chrono::steady_clock::time_point _lastOpenAttempt{};
+    std::atomic<bool> _ready{false};
+
+    std::atomic<uint64_t> _signs{0};
+    std::atomic<uint64_t> _signErrors{0};
+    std::atomic<uint64_t> _clientCreates{0};
+    std::atomic<uint64_t> _recoveries{0};
+    std::atomic<uint64_t> _keySwitches{0};
+    std::atomic<long long> _lastSignUs{0};
+    std::atomic<long long> _maxSignUs{0};
+    std::atomic<long long> _totalSignUs{0};
+    std::atomic<long long> _lastCreateUs{0};
+};
@@ -0,0 +1,232 @@
+#include "TxAckTracker.h"
+#include "../../MarketDepths/NetLoop.h"
+#include "../../MarketDepths/JsonScan.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio/steady_timer.hpp>
+
+namespace net = boost::asio;
+using Clock = std::chrono::steady_clock;
+
+static long long elapsedUs(Clock::time_point since, Clock::time_point now) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(now - since).count();
+}
+
+// Поля ответа sendtx. Lighter кладёт их то в корень, то в data, ошибку — в error{code,message}:
+// собираем с двух уровней вложенности, что нашлось
+struct TxResponse {
+    std::string_view id;
+    long long code{0};
+    bool hasCode{false};
+    std::string_view txHash;
+    std::string_view message;
+    bool hasError{false};
+};
+
+static bool scanResponseObject(jsonscan::Cursor &c, TxResponse &r, int depth) {
+    using namespace jsonscan;
+    return forEachMember(c, [&](std::string_view key, Cursor &v) {
+        if (key == "id") return readScalar(v, r.id);
+        if (key == "code") {
+            if (!readInt(v, r.code)) return false;
+            r.hasCode = true;
+            return true;
+        }
+        if (key == "tx_hash") return readScalar(v, r.txHash);
+        if (key == "message") return readScalar(v, r.message);
+        if ((key == "data" || key == "error") && depth < 2) {
+            skipWs(v);
+            if (v.p < v.end && *v.p == '{') {
+                if (key == "error") r.hasError = true;
+                return scanResponseObject(v, r, depth + 1);
+            }
+            if (key == "error") {
+                r.hasError = true;
+                return readScalar(v, r.message);
+            }
+        }
+        return skipValue(v);
+    });
+}
+
+static TxAck::Status classify(const TxResponse &r) {
+    const bool ok = r.hasCode ? r.code == 200 : (!r.hasError && !r.txHash.empty());
+    if (ok) return TxAck::Status::Accepted;
+    // 429 — HTTP-совместимый код, 23000 — код Lighter «Too Many Requests»
+    if (r.code == 429 || r.code == 23000 || r.message.find("Too Many") != std::string_view::npos ||
+        r.message.find("rate limit") != std::string_view::npos) return TxAck::Status::RateLimited;
+    if (r.message.find("nonce") != std::string_view::npos) return TxAck::Status::NonceError;
+    return TxAck::Status::Rejected;
+}
+
+struct TxAckTracker::Impl : std::enable_shared_from_this<TxAckTracker::Impl> {
+    struct Pending {
+        int txType;
+        int apiKeyIndex;
+        long long nonce;
+        Clock::time_point sentAt;
+        Callback cb;
+    };
+
+    Config cfg;
+    net::steady_timer timer;
+
+    std::mutex mtx; // pending/sweeping/stopped
+    std::unordered_map<std::string, Pending> pending;
+    bool sweeping{false};
+    bool stopped{false};
+
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> nonceErrors{0};
+    std::atomic<uint64_t> rateLimited{0};
+    std::atomic<uint64_t> timeouts{0};
+    std::atomic<uint64_t> unmatched{0};
+    std::atomic<uint64_t> acked{0};
+    std::atomic<long long> lastLatencyUs{0};
+    std::atomic<long long> maxLatencyUs{0};
+    std::atomic<long long> totalLatencyUs{0};
+
+    explicit Impl(Config c)
+            : cfg(std::move(c)), timer((cfg.loop ? *cfg.loop : NetLoop::shared()).context()) {}
+
+    void deliver(Callback &cb, const TxAck &ack) {
+        try {
+            if (cb) cb(ack);
+            if (cfg.onAck) cfg.onAck(ack);
+        } catch (const std::exception &ex) {
+            std::cerr << "[TxAckTracker] callback exception: " << ex.what() << std::endl;
+        }
+    }
+
+    void count(const TxAck &ack) {
+        switch (ack.status) {
+            case TxAck::Status::Accepted: accepted.fetch_add(1); break;
+            case TxAck::Status::Rejected: rejected.fetch_add(1); break;
+            case TxAck::Status::NonceError: nonceErrors.fetch_add(1); break;
+            case TxAck::Status::RateLimited: rateLimited.fetch_add(1); break;
+            case TxAck::Status::Timeout: timeouts.fetch_add(1); return;
+            case TxAck::Status::Superseded: return;
+        }
+        acked.fetch_add(1);
+        lastLatencyUs.store(ack.latencyUs);
+        totalLatencyUs.fetch_add(ack.latencyUs);
+        long long prev = maxLatencyUs.load();
+        while (ack.latencyUs > prev && !maxLatencyUs.compare_exchange_weak(prev, ack.latencyUs)) {}
+    }
+
+    // под mtx
+    void armSweepLocked() {
+        if (sweeping || stopped || pending.empty()) return;
+        sweeping = true;
+        timer.expires_after(std::chrono::milliseconds(cfg.sweepIntervalMs));
+        timer.async_wait([self = shared_from_this()](const boost::system::error_code &ec) {
+            if (ec) return;
+            self->sweep();
+        });
+    }
+
+    void sweep() {
+        std::vector<std::pair<TxAck, Callback>> expired;
+        const auto now = Clock::now();
+        const auto timeout = std::chrono::milliseconds(cfg.timeoutMs);
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            sweeping = false;
+            if (stopped) return;
+            for (auto it = pending.begin(); it != pending.end();) {
+                if (now - it->second.sentAt < timeout) { ++it; continue; }
+                TxAck ack;
+                ack.status = TxAck::Status::Timeout;
+                ack.id = it->first;
+                ack.txType = it->second.txType;
+                ack.apiKeyIndex = it->second.apiKeyIndex;
+                ack.nonce = it->second.nonce;
+                ack.latencyUs = elapsedUs(it->second.sentAt, now);
+                expired.emplace_back(std::move(ack), std::move(it->second.cb));
+                it = pending.erase(it);
+            }
+            armSweepLocked();
+        }
+        for (auto &e : expired) {
+            count(e.first);
+            deliver(e.second, e.first);
+        }
+    }
+};
+
+TxAckTracker::TxAckTracker(Config cfg) : _impl(std::make_shared<Impl>(std::move(cfg))) {}
+
+TxAckTracker::~TxAckTracker() {
+    std::lock_guard<std::mutex> lk(_impl->mtx);
+    _impl->stopped = true;
+    _impl->timer.cancel();
+}
+
+void TxAckTracker::track(const std::string &id, int txType, int apiKeyIndex, long long nonce, Callback cb) {
+    std::lock_guard<std::mutex> lk(_impl->mtx);
+    _impl->pending[id] = Impl::Pending{txType, apiKeyIndex, nonce, Clock::now(), std::move(cb)};
+    _impl->sent.fetch_add(1);
+    _impl->armSweepLocked();
+}
+
+bool TxAckTracker::onMessage(std::string_view json) {
+    const auto now = Clock::now();
+    // дешёвый отсев ping'ов и служебных кадров: у ответа на запрос всегда есть id
+    if (json.find("\"id\"") == std::string_view::npos) return false;
+    TxResponse r;
+    jsonscan::Cursor c(json);
+    if (!scanResponseObject(c, r, 0) || r.id.empty()) return false;
+
+    TxAck ack;
+    Callback cb;
+    {
+        std::lock_guard<std::mutex> lk(_impl->mtx);
+        auto it = _impl->pending.find(std::string(r.id));
+        if (it == _impl->pending.end()) {
+            _impl->unmatched.fetch_add(1);
+            return false;
+        }
+        ack.id = it->first;
+        ack.txType = it->second.txType;
+        ack.apiKeyIndex = it->second.apiKeyIndex;
+        ack.nonce = it->second.nonce;
+        ack.latencyUs = elapsedUs(it->second.sentAt, now);
+        cb = std::move(it->second.cb);
+        _impl->pending.erase(it);
+    }
+    ack.status = classify(r);
+    ack.code = (int)r.code;
+    ack.txHash = std::string(r.txHash);
+    ack.message = std::string(r.message);
+    _impl->count(ack);
+    _impl->deliver(cb, ack);
+    return true;
+}
+
+TxAckTracker::Stats TxAckTracker::stats() const {
+    Stats s;
+    s.sent = _impl->sent.load();
+    s.accepted = _impl->accepted.load();
+    s.rejected = _impl->rejected.load();
+    s.nonceErrors = _impl->nonceErrors.load();
+    s.rateLimited = _impl->rateLimited.load();
+    s.timeouts = _impl->timeouts.load();
+    s.unmatched = _impl->unmatched.load();
+    s.lastLatencyUs = _impl->lastLatencyUs.load();
+    s.maxLatencyUs = _impl->maxLatencyUs.load();
+    const uint64_t n = _impl->acked.load();
+    s.avgLatencyUs = n ? (long long)(_impl->totalLatencyUs.load() / (long long)n) : 0;
+    {
+        std::lock_guard<std::mutex> lk(_impl->mtx);
+        s.pending = _impl->pending.size();
+    }
+    return s;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+class NetLoop;
+
+// Итог отправки jsonapi/sendtx: ответ сервера или таймаут
+struct TxAck {
+    // RateLimited — отклонена лимитом биржи на частоту запросов.
+    // Superseded — транзакция не отправлялась: её заменило более новое намерение (см. ModifyCoalescer)
+    enum class Status { Accepted, Rejected, NonceError, RateLimited, Timeout, Superseded };
+
+    Status status{Status::Timeout};
+    std::string id;          // id запроса из кадра sendtx
+    int txType{0};
+    int apiKeyIndex{0};      // ключ, которым подписана транзакция (у каждого своя последовательность nonce)
+    long long nonce{0};
+    int code{0};             // код ответа Lighter (200 — принято), 0 при таймауте
+    std::string txHash;
+    std::string message;     // текст ошибки как есть, без раскодирования escape
+    long long latencyUs{0};  // от отправки до ответа (до таймаута — для Timeout)
+};
+
+// Таблица отправленных транзакций по id: ответы с tx-сокета находят свой запрос,
+// не дождавшиеся ответа за timeoutMs завершаются Timeout по таймеру на NetLoop.
+// Колбэки зовутся из потока цикла, вне внутренних блокировок.
+class TxAckTracker {
+public:
+    using Callback = std::function<void(const TxAck&)>;
+
+    struct Config {
+        int timeoutMs = 5000;
+        int sweepIntervalMs = 100;
+        NetLoop *loop = nullptr;  // nullptr — NetLoop::shared()
+        Callback onAck;           // для каждого итога, после колбэка самого запроса (логи, метрики)
+    };
+
+    struct Stats {
+        uint64_t sent{0};
+        uint64_t accepted{0};
+        uint64_t rejected{0};
+        uint64_t nonceErrors{0};
+        uint64_t rateLimited{0};
+        uint64_t timeouts{0};
+        uint64_t unmatched{0};      // ответы sendtx с незнакомым id (например, после таймаута)
+        size_t pending{0};
+        long long lastLatencyUs{0}; // только по полученным ответам
+        long long maxLatencyUs{0};
+        long long avgLatencyUs{0};
+    };
+
+    explicit TxAckTracker(Config cfg);
+    ~TxAckTracker();
+
+    // До отправки кадра: иначе быстрый ответ может обогнать регистрацию
+    void track(const std::string &id, int txType, int apiKeyIndex, long long nonce, Callback cb = {});
+
+    // Входящее сообщение tx-сокета; true — это был ответ на один из наших запросов
+    bool onMessage(std::string_view json);
+
+    Stats stats() const;
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> _impl; // живёт, пока на него смотрит таймер
+};
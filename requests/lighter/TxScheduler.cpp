@@ -0,0 +1,184 @@
+#include "TxScheduler.h"
+#include "../../MarketDepths/NetLoop.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio/steady_timer.hpp>
+
+namespace net = boost::asio;
+using Clock = std::chrono::steady_clock;
+
+struct TxScheduler::Impl : std::enable_shared_from_this<TxScheduler::Impl> {
+    struct Task {
+        std::function<void()> run;
+        std::function<void(const std::string &)> fail;
+        Clock::time_point queuedAt;
+    };
+
+    Config cfg;
+    net::steady_timer timer;
+
+    mutable std::mutex mtx; // всё ниже
+    double tokens;
+    double rate;
+    Clock::time_point lastRefill;
+    std::deque<Task> queues[kPriorities];
+    bool armed{false};
+    bool stopped{false};
+
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> deferred{0};
+    std::atomic<uint64_t> throttled{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<long long> lastQueueDelayUs{0};
+    std::atomic<long long> maxQueueDelayUs{0};
+
+    explicit Impl(Config c)
+            : cfg(std::move(c)), timer((cfg.loop ? *cfg.loop : NetLoop::shared()).context()),
+              tokens(cfg.burst), rate(cfg.ratePerSec), lastRefill(Clock::now()) {}
+
+    // под mtx
+    void refillLocked() {
+        const auto now = Clock::now();
+        const double dt = std::chrono::duration<double>(now - lastRefill).count();
+        lastRefill = now;
+        rate = std::min(cfg.ratePerSec, rate + cfg.recoverPerSec * dt);
+        tokens = std::min(cfg.burst, tokens + rate * dt);
+    }
+
+    // под mtx
+    bool queuedUpToLocked(int p) const {
+        for (int i = 0; i <= p; ++i) {
+            if (!queues[i].empty()) return true;
+        }
+        return false;
+    }
+
+    // под mtx: проснуться, когда накопится целый токен
+    void armLocked() {
+        if (armed || stopped || !queuedUpToLocked(kPriorities - 1)) return;
+        armed = true;
+        const double waitSec = tokens >= 1.0 ? 0.0 : (1.0 - tokens) / std::max(rate, 1e-6);
+        timer.expires_after(std::chrono::microseconds((long long) (waitSec * 1e6) + 1));
+        timer.async_wait([self = shared_from_this()](const boost::system::error_code &ec) {
+            if (ec) return;
+            self->drain();
+        });
+    }
+
+    void drain() {
+        std::vector<Task> ready;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            armed = false;
+            if (stopped) return;
+            refillLocked();
+            for (int p = 0; p < kPriorities && tokens >= 1.0; ++p) {
+                while (!queues[p].empty() && tokens >= 1.0) {
+                    tokens -= 1.0;
+                    ready.push_back(std::move(queues[p].front()));
+                    queues[p].pop_front();
+                }
+            }
+            armLocked();
+        }
+        const auto now = Clock::now();
+        // по порядку приоритета: nonce выдаются уже внутри run()
+        for (auto &t : ready) {
+            const long long us = std::chrono::duration_cast<std::chrono::microseconds>(now - t.queuedAt).count();
+            lastQueueDelayUs.store(us);
+            long long prev = maxQueueDelayUs.load();
+            while (us > prev && !maxQueueDelayUs.compare_exchange_weak(prev, us)) {}
+            sent.fetch_add(1);
+            try {
+                t.run();
+            } catch (const std::exception &ex) {
+                dropped.fetch_add(1);
+                std::cerr << "[TxScheduler] deferred tx failed: " << ex.what() << std::endl;
+                if (t.fail) t.fail(ex.what());
+            }
+        }
+    }
+};
+
+TxScheduler::TxScheduler(Config cfg) : _impl(std::make_shared<Impl>(std::move(cfg))) {}
+
+TxScheduler::~TxScheduler() {
+    std::vector<Impl::Task> pending;
+    {
+        std::lock_guard<std::mutex> lk(_impl->mtx);
+        _impl->stopped = true;
+        _impl->timer.cancel();
+        for (auto &q : _impl->queues) {
+            for (auto &t : q) pending.push_back(std::move(t));
+            q.clear();
+        }
+    }
+    // владельцы (слот modify, продление heartbeat, стратегия) должны узнать, что отправки не будет
+    for (auto &t : pending) {
+        _impl->dropped.fetch_add(1);
+        if (t.fail) t.fail("scheduler stopped");
+    }
+}
+
+void TxScheduler::submit(Priority p, std::function<void()> run, std::function<void(const std::string &)> fail) {
+    const int pi = static_cast<int>(p);
+    {
+        std::lock_guard<std::mutex> lk(_impl->mtx);
+        _impl->refillLocked();
+        if (_impl->tokens < 1.0 || _impl->queuedUpToLocked(pi)) {
+            _impl->queues[pi].push_back({std::move(run), std::move(fail), Clock::now()});
+            _impl->deferred.fetch_add(1);
+            _impl->armLocked();
+            return;
+        }
+        _impl->tokens -= 1.0;
+    }
+    _impl->sent.fetch_add(1);
+    run();
+}
+
+void TxScheduler::charge() {
+    std::lock_guard<std::mutex> lk(_impl->mtx);
+    _impl->refillLocked();
+    _impl->tokens -= 1.0; // может уйти в минус: очередь подождёт, пока долг не погасится
+    _impl->sent.fetch_add(1);
+}
+
+void TxScheduler::onThrottled() {
+    std::lock_guard<std::mutex> lk(_impl->mtx);
+    _impl->refillLocked();
+    _impl->throttled.fetch_add(1);
+    _impl->rate = std::max(_impl->cfg.minRatePerSec, _impl->rate * _impl->cfg.backoff);
+    // биржа уже считает нас за лимитом — накопленное не тратим
+    _impl->tokens = std::min(_impl->tokens, 0.0);
+    std::cerr << "[TxScheduler] throttled by exchange, rate -> " << _impl->rate << " tx/s" << std::endl;
+}
+
+TxScheduler::Budget TxScheduler::budget() const {
+    Budget b;
+    std::lock_guard<std::mutex> lk(_impl->mtx);
+    _impl->refillLocked();
+    b.tokens = _impl->tokens;
+    b.ratePerSec = _impl->rate;
+    for (int i = 0; i < kPriorities; ++i) b.queued[i] = _impl->queues[i].size();
+    return b;
+}
+
+TxScheduler::Stats TxScheduler::stats() const {
+    Stats s;
+    s.sent = _impl->sent.load();
+    s.deferred = _impl->deferred.load();
+    s.throttled = _impl->throttled.load();
+    s.dropped = _impl->dropped.load();
+    s.lastQueueDelayUs = _impl->lastQueueDelayUs.load();
+    s.maxQueueDelayUs = _impl->maxQueueDelayUs.load();
+    s.budget = budget();
+    return s;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <functional>
+#include <string>
+#include <cstdint>
+
+class NetLoop;
+
+// Token bucket перед выдачей nonce: каждая транзакция тратит токен, без токена — ждёт в очереди
+// своего приоритета (cancel > modify > create). Порядок меняется только до выдачи nonce,
+// иначе обгон по приоритету оставил бы дыру в последовательности.
+// Лимит учится по ответам: throttle от биржи режет скорость вдвое (не ниже minRatePerSec),
+// затем она линейно восстанавливается до ratePerSec. Дозаправка очереди — таймер на NetLoop.
+class TxScheduler {
+public:
+    enum class Priority { Cancel = 0, Modify = 1, Create = 2 };
+    static constexpr int kPriorities = 3;
+
+    struct Config {
+        double ratePerSec = 40.0;    // потолок скорости (токенов в секунду)
+        double burst = 40.0;         // ёмкость ведра
+        double minRatePerSec = 0.5;
+        double backoff = 0.5;        // множитель скорости при throttle
+        double recoverPerSec = 2.0;  // прирост скорости (ток./с) за каждую секунду без throttle
+        NetLoop *loop = nullptr;     // nullptr — NetLoop::shared()
+    };
+
+    // Сколько можно отправить прямо сейчас — для решений стратегии
+    struct Budget {
+        double tokens{0};        // доступно сейчас (может быть < 1 — тогда ждём)
+        double ratePerSec{0};    // текущая выученная скорость
+        size_t queued[kPriorities]{};
+    };
+
+    struct Stats {
+        uint64_t sent{0};            // выдано токенов
+        uint64_t deferred{0};        // ждали в очереди
+        uint64_t throttled{0};       // ответов биржи о превышении лимита
+        uint64_t dropped{0};         // отложенная задача упала при запуске или снята остановкой
+        long long lastQueueDelayUs{0};
+        long long maxQueueDelayUs{0};
+        Budget budget;
+    };
+
+    explicit TxScheduler(Config cfg);
+    ~TxScheduler();
+
+    // Есть токен и нет очереди не ниже по приоритету — run() сразу в этом потоке (исключения — наружу).
+    // Иначе — в очередь; при отложенном запуске исключение из run() уходит в fail()
+    void submit(Priority p, std::function<void()> run, std::function<void(const std::string &error)> fail = {});
+    // Транзакция, отправленная мимо очереди (синхронный путь): только списать токен
+    void charge();
+
+    // Биржа ответила превышением лимита
+    void onThrottled();
+
+    Budget budget() const;
+    Stats stats() const;
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> _impl; // живёт, пока на него смотрит таймер
+};